@@ -0,0 +1,73 @@
+/**
+ * Timing helpers shared by the benchmark executables.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_BENCH_BENCH_H_
+#define EYEDID_CPP_SAMPLE_BENCH_BENCH_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace sample {
+namespace bench {
+
+inline std::int64_t nowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** Keep the compiler from discarding a result that is never read */
+inline void keep(const void* p) {
+#if defined(__GNUC__)
+  asm volatile("" : : "g"(p) : "memory");
+#else
+  static const void* volatile sink;
+  sink = p;
+#endif
+}
+
+/** Value at `fraction` (0..1) of the sorted samples. Sorts `samples` */
+template<typename T>
+T percentile(std::vector<T>* samples, double fraction) {
+  if (samples->empty())
+    return T();
+  std::sort(samples->begin(), samples->end());
+  const auto index = static_cast<std::size_t>(fraction * static_cast<double>(samples->size() - 1) + 0.5);
+  return (*samples)[index];
+}
+
+/**
+ * Median time of one call of `fn`, in microseconds.
+ * `fn` runs once to warm up, then `repeats` times.
+ */
+template<typename F>
+double medianMicros(int repeats, F&& fn) {
+  fn();
+  std::vector<double> samples;
+  samples.reserve(static_cast<std::size_t>(repeats));
+  for (int i = 0; i < repeats; ++i) {
+    const auto start = nowNanos();
+    fn();
+    samples.push_back(static_cast<double>(nowNanos() - start) / 1000.0);
+  }
+  return percentile(&samples, 0.5);
+}
+
+/**
+ * Mean time of one call of `fn` over a batch of `calls` calls, in nanoseconds.
+ * For operations too short to time one by one. The median of `repeats` batches is taken.
+ */
+template<typename F>
+double batchNanos(int repeats, int calls, F&& fn) {
+  return medianMicros(repeats, [&]() {
+    for (int i = 0; i < calls; ++i)
+      fn();
+  }) * 1000.0 / calls;
+}
+
+} // namespace bench
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_BENCH_BENCH_H_
@@ -0,0 +1,149 @@
+/**
+ * Camera format to RGB: the one-pass kernels of color_convert.h against cv::cvtColor,
+ * both in one call (YUV to RGB) and in the two steps the sample used to take
+ * (YUV to BGR for the preview, then BGR to RGB for the tracker).
+ *
+ *   color_convert_bench           time every path at 720p and 1080p
+ *   color_convert_bench --check   verify that every instruction set matches the scalar kernels
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "opencv2/opencv.hpp"
+
+#include "bench.h"
+#include "color_convert.h"
+
+namespace {
+
+using convert_fn = void (*)(const cv::Mat& src, cv::Mat* dst);
+
+void fillRandom(cv::Mat* mat, std::mt19937* rng) {
+  std::uniform_int_distribution<int> byte(0, 255);
+  const auto row_bytes = static_cast<std::size_t>(mat->cols) * mat->elemSize();
+  for (int r = 0; r < mat->rows; ++r) {
+    auto* row = mat->ptr(r);
+    for (std::size_t i = 0; i < row_bytes; ++i)
+      row[i] = static_cast<std::uint8_t>(byte(*rng));
+  }
+}
+
+bool sameRGB(const cv::Mat& a, const cv::Mat& b) {
+  if (a.rows != b.rows || a.cols != b.cols || a.type() != b.type())
+    return false;
+  const auto row_bytes = static_cast<std::size_t>(a.cols) * 3;
+  for (int r = 0; r < a.rows; ++r) {
+    if (std::memcmp(a.ptr(r), b.ptr(r), row_bytes) != 0)
+      return false;
+  }
+  return true;
+}
+
+/** Source images for the check: every small width, and the benchmark sizes */
+std::vector<cv::Size> checkSizes() {
+  std::vector<cv::Size> sizes;
+  for (int width = 1; width <= 80; ++width) {
+    sizes.emplace_back(width, 2);
+    sizes.emplace_back(width, 6);
+  }
+  sizes.emplace_back(1280, 720);
+  sizes.emplace_back(1920, 1080);
+  return sizes;
+}
+
+int check() {
+  const auto isas = sample::colorConvertIsas();
+  struct Case {
+    const char* name;
+    convert_fn convert;
+    int type;
+    bool nv12;
+  };
+  const Case cases[] = {
+    {"yuyv", sample::yuyvToRGB, CV_8UC2, false},
+    {"nv12", sample::nv12ToRGB, CV_8UC1, true},
+    {"bgr", sample::bgrToRGB, CV_8UC3, false},
+  };
+
+  std::mt19937 rng(42);
+  int failures = 0;
+  for (const auto& c : cases) {
+    for (const auto& size : checkSizes()) {
+      // NV12 needs even dimensions
+      if (c.nv12 && size.width % 2 != 0)
+        continue;
+      cv::Mat src(c.nv12 ? size.height * 3 / 2 : size.height, size.width, c.type);
+      fillRandom(&src, &rng);
+
+      cv::Mat expected;
+      sample::setColorConvertIsa("scalar");
+      c.convert(src, &expected);
+      for (const auto& isa : isas) {
+        cv::Mat actual;
+        sample::setColorConvertIsa(isa);
+        c.convert(src, &actual);
+        if (!sameRGB(expected, actual)) {
+          std::printf("%s %dx%d: %s differs from scalar\n", c.name, size.width, size.height, isa.c_str());
+          ++failures;
+        }
+      }
+    }
+  }
+  sample::setColorConvertIsa(isas.back());
+
+  std::printf("%s: %d mismatches\n", failures == 0 ? "ok" : "FAILED", failures);
+  return failures == 0 ? 0 : 1;
+}
+
+void timeFormat(const char* name, const cv::Mat& src, convert_fn convert, int to_rgb, int to_bgr) {
+  const int repeats = 50;
+  cv::Mat rgb, bgr;
+
+  for (const auto& isa : sample::colorConvertIsas()) {
+    sample::setColorConvertIsa(isa);
+    const auto us = sample::bench::medianMicros(repeats, [&]() { convert(src, &rgb); });
+    std::printf("  %-5s one pass, %-8s %8.0f us\n", name, isa.c_str(), us);
+  }
+  const auto isas = sample::colorConvertIsas();
+  sample::setColorConvertIsa(isas.back());
+
+  const auto direct_us = sample::bench::medianMicros(repeats, [&]() { cv::cvtColor(src, rgb, to_rgb); });
+  std::printf("  %-5s cvtColor to RGB    %8.0f us\n", name, direct_us);
+
+  const auto two_step_us = sample::bench::medianMicros(repeats, [&]() {
+    cv::cvtColor(src, bgr, to_bgr);
+    cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+  });
+  std::printf("  %-5s two step via BGR   %8.0f us\n", name, two_step_us);
+}
+
+void bench() {
+  std::printf("OpenCV threads: %d\n", cv::getNumThreads());
+  std::mt19937 rng(1);
+  const cv::Size sizes[] = {{1280, 720}, {1920, 1080}};
+  for (const auto& size : sizes) {
+    std::printf("%dx%d\n", size.width, size.height);
+
+    cv::Mat yuyv(size.height, size.width, CV_8UC2);
+    fillRandom(&yuyv, &rng);
+    timeFormat("yuyv", yuyv, sample::yuyvToRGB, cv::COLOR_YUV2RGB_YUYV, cv::COLOR_YUV2BGR_YUYV);
+
+    cv::Mat nv12(size.height * 3 / 2, size.width, CV_8UC1);
+    fillRandom(&nv12, &rng);
+    timeFormat("nv12", nv12, sample::nv12ToRGB, cv::COLOR_YUV2RGB_NV12, cv::COLOR_YUV2BGR_NV12);
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 1 && std::string(argv[1]) == "--check")
+    return check();
+  bench();
+  return 0;
+}
@@ -0,0 +1,285 @@
+/**
+ * Jitter against lag of the gaze filters on a gaze trace.
+ *
+ *   gaze_filter_bench [--filter=SPEC]... [TRACE]   score the filters on TRACE, or on the synthetic trace
+ *   gaze_filter_bench --generate=TRACE             write the synthetic trace
+ *
+ * SPEC is a --gaze-filter value of the sample. A trace is CSV with the header
+ * `timestamp_ms,x,y,state[,target_x,target_y]`, where state is `fixation` or `saccade`.
+ * Without target columns, the target of a fixation is the mean of its raw points.
+ *
+ * The synthetic trace is sampled at 30 Hz: 400 fixations of 9 to 20 samples, each after
+ * a saccade of 2 samples, with 15 px of gaussian noise per axis.
+ *
+ * Jitter is the RMS distance of the filtered points to the target, from 200 ms into
+ * a fixation. Lag is the time from the start of a fixation until a filtered point is
+ * within 25 px of the target.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "opencv2/opencv.hpp"
+
+#include "bench.h"
+#include "gaze_filter.h"
+#include "options.h"
+
+namespace {
+
+using sample::GazeFilter;
+
+constexpr std::uint64_t kSettledMs = 200;
+constexpr float kOnTargetPx = 25.0f;
+
+struct Sample {
+  std::uint64_t timestamp_ms = 0;
+  cv::Point2f raw;
+  bool fixation = false;
+  cv::Point2f target;
+  bool has_target = false;
+};
+
+std::vector<Sample> syntheticTrace() {
+  std::mt19937 rng(1);
+  std::normal_distribution<float> noise(0.0f, 15.0f);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+  std::vector<Sample> trace;
+  std::uint64_t timestamp_ms = 0;
+  cv::Point2f position(960, 540);
+  for (int fixation = 0; fixation < 400; ++fixation) {
+    const cv::Point2f target(200 + 1500 * unit(rng), 100 + 880 * unit(rng));
+    for (int i = 0; i < 2; ++i, timestamp_ms += 33) {
+      const auto truth = position + (target - position) * ((i + 1) / 2.0f);
+      Sample sample;
+      sample.timestamp_ms = timestamp_ms;
+      sample.raw = truth + cv::Point2f(noise(rng), noise(rng));
+      sample.target = truth;
+      sample.has_target = true;
+      trace.push_back(sample);
+    }
+    position = target;
+
+    const int samples = 9 + static_cast<int>(unit(rng) * 12);
+    for (int i = 0; i < samples; ++i, timestamp_ms += 33) {
+      Sample sample;
+      sample.timestamp_ms = timestamp_ms;
+      sample.raw = target + cv::Point2f(noise(rng), noise(rng));
+      sample.fixation = true;
+      sample.target = target;
+      sample.has_target = true;
+      trace.push_back(sample);
+    }
+  }
+  return trace;
+}
+
+bool writeTrace(const std::string& path, const std::vector<Sample>& trace) {
+  std::ofstream out(path);
+  if (!out)
+    return false;
+  out << "timestamp_ms,x,y,state,target_x,target_y\n";
+  for (const auto& sample : trace) {
+    out << sample.timestamp_ms << ',' << sample.raw.x << ',' << sample.raw.y << ','
+        << (sample.fixation ? "fixation" : "saccade") << ','
+        << sample.target.x << ',' << sample.target.y << '\n';
+  }
+  return static_cast<bool>(out);
+}
+
+bool parseSample(const std::string& line, Sample* sample) {
+  std::vector<std::string> fields;
+  std::stringstream stream(line);
+  std::string field;
+  while (std::getline(stream, field, ','))
+    fields.push_back(field);
+  if (fields.size() != 4 && fields.size() != 6)
+    return false;
+  if (fields[3] != "fixation" && fields[3] != "saccade")
+    return false;
+
+  try {
+    sample->timestamp_ms = std::stoull(fields[0]);
+    sample->raw = { std::stof(fields[1]), std::stof(fields[2]) };
+    sample->fixation = fields[3] == "fixation";
+    sample->has_target = fields.size() == 6;
+    if (sample->has_target)
+      sample->target = { std::stof(fields[4]), std::stof(fields[5]) };
+  }
+  catch (const std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+/** Fixations without a target get the mean of their raw points */
+void fillTargets(std::vector<Sample>* trace) {
+  std::size_t begin = 0;
+  while (begin < trace->size()) {
+    auto end = begin + 1;
+    while (end < trace->size() && (*trace)[end].fixation == (*trace)[begin].fixation)
+      ++end;
+    if ((*trace)[begin].fixation) {
+      cv::Point2f sum;
+      for (auto i = begin; i < end; ++i)
+        sum += (*trace)[i].raw;
+      const auto mean = sum * (1.0f / static_cast<float>(end - begin));
+      for (auto i = begin; i < end; ++i) {
+        if (!(*trace)[i].has_target)
+          (*trace)[i].target = mean;
+      }
+    }
+    begin = end;
+  }
+}
+
+bool readTrace(const std::string& path, std::vector<Sample>* trace) {
+  std::ifstream in(path);
+  if (!in) {
+    std::cerr << path << ": cannot open\n";
+    return false;
+  }
+  std::string line;
+  int number = 0;
+  while (std::getline(in, line)) {
+    ++number;
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (line.empty() || (number == 1 && line.compare(0, 12, "timestamp_ms") == 0))
+      continue;
+    Sample sample;
+    if (!parseSample(line, &sample)) {
+      std::cerr << path << ':' << number << ": expected timestamp_ms,x,y,fixation|saccade[,target_x,target_y]\n";
+      return false;
+    }
+    trace->push_back(sample);
+  }
+  fillTargets(trace);
+  return true;
+}
+
+struct Score {
+  double jitter_px = 0;
+  double lag_ms = 0;
+  int fixations = 0;
+  int settled = 0;
+};
+
+Score score(const GazeFilter::Params& params, const std::vector<Sample>& trace) {
+  GazeFilter filter(params);
+  double squared_error = 0;
+  int jitter_samples = 0;
+  double lag_ms = 0;
+  Score result;
+
+  std::uint64_t fixation_start_ms = 0;
+  bool in_fixation = false;
+  bool settled = false;
+  for (const auto& sample : trace) {
+    const auto point = filter.filter(sample.raw, sample.timestamp_ms);
+    if (!sample.fixation) {
+      in_fixation = false;
+      continue;
+    }
+    if (!in_fixation) {
+      in_fixation = true;
+      settled = false;
+      fixation_start_ms = sample.timestamp_ms;
+      ++result.fixations;
+    }
+
+    const auto error = std::hypot(point.x - sample.target.x, point.y - sample.target.y);
+    const auto elapsed_ms = sample.timestamp_ms - fixation_start_ms;
+    if (!settled && error < kOnTargetPx) {
+      settled = true;
+      lag_ms += static_cast<double>(elapsed_ms);
+      ++result.settled;
+    }
+    if (elapsed_ms >= kSettledMs) {
+      squared_error += error * error;
+      ++jitter_samples;
+    }
+  }
+
+  if (jitter_samples > 0)
+    result.jitter_px = std::sqrt(squared_error / jitter_samples);
+  if (result.settled > 0)
+    result.lag_ms = lag_ms / result.settled;
+  return result;
+}
+
+double nanosPerPoint(const GazeFilter::Params& params, const std::vector<Sample>& trace) {
+  GazeFilter filter(params);
+  std::size_t index = 0;
+  std::uint64_t timestamp_ms = 0;
+  cv::Point2f point;
+  const auto ns = sample::bench::batchNanos(20, 100000, [&]() {
+    point = filter.filter(trace[index].raw, timestamp_ms += 33);
+    if (++index == trace.size())
+      index = 0;
+  });
+  sample::bench::keep(&point);
+  return ns;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::vector<std::string> specs;
+  std::string trace_path;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg.compare(0, 11, "--generate=") == 0) {
+      if (!writeTrace(arg.substr(11), syntheticTrace())) {
+        std::cerr << arg.substr(11) << ": cannot write\n";
+        return 1;
+      }
+      return 0;
+    }
+    else if (arg.compare(0, 9, "--filter=") == 0) {
+      specs.push_back(arg.substr(9));
+    }
+    else if (arg.compare(0, 2, "--") != 0 && trace_path.empty()) {
+      trace_path = arg;
+    }
+    else {
+      std::cerr << "Usage: " << argv[0] << " [--filter=SPEC]... [TRACE] | --generate=TRACE\n";
+      return 1;
+    }
+  }
+  if (specs.empty())
+    specs = { "none", "mean:3", "mean:5", "one-euro:1,0.007", "one-euro:0.5,0.004", "kalman:4000,10" };
+  std::vector<GazeFilter::Params> filters(specs.size());
+  for (std::size_t i = 0; i < specs.size(); ++i) {
+    if (!sample::parseGazeFilter(specs[i], &filters[i])) {
+      std::cerr << specs[i] << ": invalid filter\n";
+      return 1;
+    }
+  }
+
+  std::vector<Sample> trace;
+  if (trace_path.empty())
+    trace = syntheticTrace();
+  else if (!readTrace(trace_path, &trace))
+    return 1;
+  if (trace.empty()) {
+    std::cerr << trace_path << ": no samples\n";
+    return 1;
+  }
+
+  std::printf("%-20s %10s %8s %10s %8s\n", "filter", "jitter", "lag", "settled", "cost");
+  for (std::size_t i = 0; i < specs.size(); ++i) {
+    const auto result = score(filters[i], trace);
+    std::printf("%-20s %7.1f px %5.0f ms %4d/%-5d %5.1f ns\n", specs[i].c_str(), result.jitter_px, result.lag_ms,
+                result.settled, result.fixations, nanosPerPoint(filters[i], trace));
+  }
+  return 0;
+}
@@ -0,0 +1,161 @@
+/**
+ * Tail latency of the on_gaze_ slot, View::setGaze, while the view is drawing.
+ *
+ * A writer thread emits a gaze point every 3 ms, like the SDK callback thread, while a
+ * render thread runs the view's update loop and a preview thread publishes frames at 30 fps.
+ * The threads share one core, so the writer is regularly preempted mid-handoff.
+ *
+ * "locked" reproduces the PriorityMutex the view used before: listeners took its low
+ * side around setGaze, and the render thread held the high side for the whole draw.
+ * "lock-free" is the current triple_buffer handoff.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+#include "opencv2/opencv.hpp"
+
+#include "bench.h"
+#include "simple_signal.h"
+#include "view.h"
+
+namespace {
+
+/** The lock paths of the removed PriorityMutex: waiting low lockers yield to high ones */
+class PriorityMutex {
+ public:
+  void lock_low() {
+    std::unique_lock<std::mutex> lck(m_);
+    cv_.wait(lck, [this]() { return !high_accessing_; });
+    lck.release();
+  }
+  void unlock_low() {
+    m_.unlock();
+    cv_.notify_one();
+  }
+  void lock_high() {
+    ++high_accessing_;
+    m_.lock();
+    --high_accessing_;
+  }
+  void unlock_high() {
+    m_.unlock();
+    cv_.notify_one();
+  }
+
+ private:
+  std::mutex m_;
+  std::condition_variable cv_;
+  std::atomic_int high_accessing_{0};
+};
+
+void pinToFirstCore() {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(0, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+struct Result {
+  std::vector<double> latency_us;
+  std::uint64_t draws = 0;
+};
+
+Result run(bool locked, int samples) {
+  sample::View view(1920, 1080, "bench", 1.0, true);
+  view.heatmap().visible = true;
+  PriorityMutex mutex;
+  std::atomic_bool stop{false};
+
+  std::thread renderer([&]() {
+    pinToFirstCore();
+    while (!stop.load(std::memory_order_relaxed)) {
+      if (locked) {
+        view.scheduler().wait();
+        mutex.lock_high();
+        view.draw(0);
+        mutex.unlock_high();
+      }
+      else {
+        view.update();
+      }
+    }
+  });
+
+  std::thread preview([&]() {
+    pinToFirstCore();
+    const cv::Mat frame(view.previewSize(), CV_8UC3, cv::Scalar(40, 80, 120));
+    while (!stop.load(std::memory_order_relaxed)) {
+      if (locked)
+        mutex.lock_low();
+      frame.copyTo(view.previewBuffer());
+      view.publishPreview();
+      if (locked)
+        mutex.unlock_low();
+      std::this_thread::sleep_for(std::chrono::milliseconds(33));
+    }
+  });
+
+  sample::signal<void(int, int, bool)> on_gaze;
+  if (locked) {
+    on_gaze.connect([&](int x, int y, bool valid) {
+      mutex.lock_low();
+      view.setGaze(x, y, valid);
+      mutex.unlock_low();
+    });
+  }
+  else {
+    on_gaze.connect([&](int x, int y, bool valid) { view.setGaze(x, y, valid); });
+  }
+
+  Result result;
+  result.latency_us.reserve(static_cast<std::size_t>(samples));
+  pinToFirstCore();
+  for (int i = 0; i < samples; ++i) {
+    const auto x = 200 + (i * 7) % 1500;
+    const auto y = 200 + (i * 13) % 700;
+    const auto start = sample::bench::nowNanos();
+    on_gaze(x, y, true);
+    result.latency_us.push_back(static_cast<double>(sample::bench::nowNanos() - start) / 1000.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+  }
+
+  stop = true;
+  view.scheduler().notify();
+  renderer.join();
+  preview.join();
+  result.draws = view.stats().draws;
+  return result;
+}
+
+void print(const char* name, Result result) {
+  auto& l = result.latency_us;
+  const auto p50 = sample::bench::percentile(&l, 0.5);
+  const auto p99 = sample::bench::percentile(&l, 0.99);
+  const auto p999 = sample::bench::percentile(&l, 0.999);
+  std::printf("  %-10s p50 %8.2f us  p99 %8.2f us  p99.9 %8.2f us  max %8.2f us  (%llu draws)\n",
+              name, p50, p99, p999, l.back(), static_cast<unsigned long long>(result.draws));
+}
+
+} // namespace
+
+int main() {
+  const int samples = 1000;
+  std::printf("on_gaze_ -> View::setGaze, %d points every 3 ms, 1920x1080 headless view\n", samples);
+  print("locked", run(true, samples));
+  print("lock-free", run(false, samples));
+  return 0;
+}
@@ -0,0 +1,80 @@
+/**
+ * Cost of drawing the camera preview (drawables::Image) into the view's back buffer.
+ *
+ * Before, Image::draw resized the buffer on every draw. Now the scaled image is cached
+ * until the buffer is invalidated, so only the first draw of a camera frame scales and
+ * later draws of the same frame are a copy. With the preview listener scaling each frame
+ * to the drawn size, no draw scales at all.
+ */
+
+#include <algorithm>
+#include <cstdio>
+
+#include "opencv2/opencv.hpp"
+
+#include "bench.h"
+#include "drawables.h"
+
+namespace {
+
+/** Image::draw before the scaled image was cached */
+void drawResizing(const cv::Mat& buffer, cv::Point tl, cv::Size size, cv::Mat* resized, cv::Mat* dst) {
+  cv::resize(buffer, *resized, size);
+  const auto img_w = std::min(resized->cols, dst->cols - tl.x);
+  const auto img_h = std::min(resized->rows, dst->rows - tl.y);
+  (*resized)(cv::Rect(0, 0, img_w, img_h)).copyTo((*dst)(cv::Rect(tl.x, tl.y, img_w, img_h)));
+}
+
+void benchPreview(cv::Size camera, cv::Size view, cv::Size preview) {
+  const int repeats = 200;
+  std::printf("camera %dx%d, preview %dx%d in a %dx%d view\n",
+              camera.width, camera.height, preview.width, preview.height, view.width, view.height);
+
+  cv::Mat dst(view, CV_8UC3, cv::Scalar(0, 0, 0));
+  const cv::Mat frame(camera, CV_8UC3, cv::Scalar(40, 80, 120));
+
+  cv::Mat resized;
+  const auto before_us = sample::bench::medianMicros(repeats, [&]() {
+    drawResizing(frame, {}, preview, &resized, &dst);
+  });
+
+  // Drawn at camera size: the first draw of a frame scales, the others copy
+  sample::drawables::Image image;
+  image.size = preview;
+  image.buffer = frame;
+  const auto new_frame_us = sample::bench::medianMicros(repeats, [&]() {
+    image.invalidate();
+    image.draw(&dst);
+  });
+  const auto same_frame_us = sample::bench::medianMicros(repeats, [&]() { image.draw(&dst); });
+
+  // Scaled by the preview listener: every draw copies, and each frame is scaled once off the render thread
+  sample::drawables::Image prescaled;
+  prescaled.size = preview;
+  cv::resize(frame, prescaled.buffer, preview);
+  const auto prescaled_us = sample::bench::medianMicros(repeats, [&]() { prescaled.draw(&dst); });
+  cv::Mat scaled;
+  const auto listener_us = sample::bench::medianMicros(repeats, [&]() { cv::resize(frame, scaled, preview); });
+
+  std::printf("  resize on every draw       %8.0f us/draw\n", before_us);
+  std::printf("  cached, new frame          %8.0f us/draw\n", new_frame_us);
+  std::printf("  cached, same frame         %8.0f us/draw\n", same_frame_us);
+  std::printf("  scaled by the listener     %8.0f us/draw, plus %.0f us/frame on the listener thread\n",
+              prescaled_us, listener_us);
+  for (int draws = 1; draws <= 4; ++draws) {
+    const auto cached_us = (new_frame_us + (draws - 1) * same_frame_us) / draws;
+    std::printf("  %d draws per camera frame:  %8.0f -> %.0f us/draw cached, %.0f us/draw prescaled\n",
+                draws, before_us, cached_us, prescaled_us);
+  }
+}
+
+} // namespace
+
+int main() {
+  std::printf("OpenCV threads: %d\n", cv::getNumThreads());
+  benchPreview({1280, 720}, {1920, 1080}, {1280, 720});
+  benchPreview({1920, 1080}, {1920, 1080}, {1280, 720});
+  // --render-scale=0.5
+  benchPreview({1920, 1080}, {960, 540}, {640, 360});
+  return 0;
+}
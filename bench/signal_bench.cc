@@ -0,0 +1,247 @@
+/**
+ * sample::signal against the signal it replaced: std::function slots in a std::list that
+ * emission walks under the connect mutex, with tracked connections wrapped in a second
+ * std::function. Measures connect allocations and emission time, tracked and untracked,
+ * on one thread and with several threads emitting at once, while slots are connected and
+ * disconnected or not.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "simple_signal.h"
+
+namespace {
+
+std::atomic<std::uint64_t> allocations{0};
+
+} // namespace
+
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+namespace legacy {
+
+/**
+ * The signal as it was before slots were stored inline, trimmed to what is measured.
+ * The original dropped the mutex around each call, so a concurrent emission could erase the
+ * slot being called. This copy holds it throughout, which only makes it cheaper.
+ */
+template<typename F>
+class signal;
+
+template<typename R, typename ...Args>
+class signal<R(Args...)> {
+ public:
+  using function_type = std::function<R(Args...)>;
+
+  struct slot {
+    explicit slot(function_type f) : func(std::move(f)) {}
+    std::atomic_bool expired{false};
+    function_type func;
+  };
+
+  std::shared_ptr<slot> connect(function_type func) {
+    auto new_slot = std::make_shared<slot>(std::move(func));
+    std::lock_guard<std::mutex> lck(connect_mutex_);
+    slot_list_.emplace_back(new_slot);
+    return new_slot;
+  }
+
+  template<typename T>
+  std::shared_ptr<slot> connect(function_type func, std::shared_ptr<T> track) {
+    std::weak_ptr<void> weak_ptr = std::move(track);
+    return connect([=](Args&&... args) {
+      auto lck = weak_ptr.lock();
+      if (lck)
+        func(std::forward<Args>(args)...);
+    });
+  }
+
+  template<typename ...Args2>
+  void operator()(Args2&&... args) {
+    std::lock_guard<std::mutex> lck(connect_mutex_);
+    auto it = slot_list_.begin();
+    while (it != slot_list_.end()) {
+      if ((*it)->expired) {
+        it = slot_list_.erase(it);
+        continue;
+      }
+      (*it)->func(args...);
+      ++it;
+    }
+  }
+
+ private:
+  std::mutex connect_mutex_;
+  std::list<std::shared_ptr<slot>> slot_list_;
+};
+
+} // namespace legacy
+
+namespace {
+
+using signature = void(std::uint64_t*);
+
+/**
+ * A slot with a 24-byte capture, typical of the sample's slots.
+ * Each emitter passes its own sum, so concurrent emitters share no data.
+ */
+struct Slot {
+  std::uint64_t scale;
+  std::uint64_t offset;
+  std::uint64_t mask;
+
+  void operator()(std::uint64_t* sum) const { *sum = (*sum * scale + offset) & mask; }
+};
+
+template<typename Signal>
+auto connectOne(Signal* sig, int i, const std::shared_ptr<int>& track) -> decltype(sig->connect(Slot())) {
+  const Slot slot{static_cast<std::uint64_t>(i + 1), static_cast<std::uint64_t>(i), ~0ull};
+  if (track)
+    return sig->connect(slot, track);
+  return sig->connect(slot);
+}
+
+template<typename S>
+void release(const std::shared_ptr<S>& slot) {
+  slot->expired = true;
+}
+
+void release(sample::connection& connection) {
+  connection.disconnect();
+}
+
+template<typename Signal>
+std::uint64_t connectAll(Signal* sig, int count, const std::shared_ptr<int>& track) {
+  const auto before = allocations.load(std::memory_order_relaxed);
+  for (int i = 0; i < count; ++i)
+    connectOne(sig, i, track);
+  return allocations.load(std::memory_order_relaxed) - before;
+}
+
+template<typename Signal>
+void benchOne(const char* name, int slots, bool tracked) {
+  Signal sig;
+  std::uint64_t sum = 0;
+  auto track = tracked ? std::make_shared<int>(0) : std::shared_ptr<int>();
+  const auto allocs = connectAll(&sig, slots, track);
+
+  const int calls = 10000;
+  const auto ns = sample::bench::batchNanos(50, calls, [&]() { sig(&sum); });
+  sample::bench::keep(&sum);
+  std::printf("  %-8s %-9s %2d slots: %7.1f ns/emit, %5.2f allocations/connect\n",
+              name, tracked ? "tracked" : "untracked", slots, ns,
+              static_cast<double>(allocs) / slots);
+}
+
+/**
+ * Mean time of one emit while `emitters` threads emit at once, in nanoseconds per thread.
+ * With `churn`, another thread connects and disconnects a slot in a loop meanwhile.
+ */
+template<typename Signal>
+double concurrentNanos(Signal* sig, int emitters, bool churn) {
+  const int calls = 20000;
+  std::vector<double> samples;
+  for (int repeat = 0; repeat < 7; ++repeat) {
+    std::atomic<int> ready{0};
+    std::atomic_bool go{false};
+    std::atomic_bool done{false};
+    std::vector<std::int64_t> elapsed(static_cast<std::size_t>(emitters));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < emitters; ++t) {
+      threads.emplace_back([&, t]() {
+        std::uint64_t sum = 0;
+        ready.fetch_add(1);
+        while (!go.load())
+          std::this_thread::yield();
+        const auto start = sample::bench::nowNanos();
+        for (int i = 0; i < calls; ++i)
+          (*sig)(&sum);
+        elapsed[static_cast<std::size_t>(t)] = sample::bench::nowNanos() - start;
+        sample::bench::keep(&sum);
+      });
+    }
+    std::thread churner;
+    if (churn) {
+      churner = std::thread([&]() {
+        while (!done.load()) {
+          auto connection = connectOne(sig, 0, nullptr);
+          release(connection);
+        }
+      });
+    }
+
+    while (ready.load() < emitters)
+      std::this_thread::yield();
+    go.store(true);
+    for (auto& thread : threads)
+      thread.join();
+    done.store(true);
+    if (churner.joinable())
+      churner.join();
+
+    std::int64_t total = 0;
+    for (const auto ns : elapsed)
+      total += ns;
+    samples.push_back(static_cast<double>(total) / emitters / calls);
+  }
+  return sample::bench::percentile(&samples, 0.5);
+}
+
+template<typename Signal>
+void benchConcurrent(const char* name, int slots, int emitters, bool churn) {
+  Signal sig;
+  connectAll(&sig, slots, nullptr);
+  std::printf("  %-8s %d emitters%s %2d slots: %7.1f ns/emit\n", name, emitters,
+              churn ? " + churn" : "        ", slots, concurrentNanos(&sig, emitters, churn));
+}
+
+} // namespace
+
+int main() {
+  std::printf("One thread emitting\n");
+  for (const bool tracked : {false, true}) {
+    for (const int slots : {1, 4, 16}) {
+      benchOne<legacy::signal<signature>>("list", slots, tracked);
+      benchOne<sample::signal<signature>>("inline", slots, tracked);
+    }
+  }
+
+  // The list signal serializes emitters on its mutex; the snapshot lets them run in parallel.
+  // Churn connects and disconnects a slot meanwhile, which copies the snapshot each time.
+  std::printf("Threads emitting at once (%u cores)\n", std::thread::hardware_concurrency());
+  for (const bool churn : {false, true}) {
+    for (const int emitters : {2, 4}) {
+      for (const int slots : {1, 4, 16}) {
+        benchConcurrent<legacy::signal<signature>>("list", slots, emitters, churn);
+        benchConcurrent<sample::signal<signature>>("inline", slots, emitters, churn);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * Drawing the view's help texts (View::desc_) with cv::putText on every draw, against
+ * blending the masks cached by drawables::TextSpriteCache.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "opencv2/opencv.hpp"
+
+#include "bench.h"
+#include "drawables.h"
+
+namespace {
+
+/** The texts View::initElements adds, laid out the same way */
+std::vector<sample::drawables::Text> helpTexts(double render_scale, int rows, int line_type) {
+  const char* const texts[] = {
+    "Press ESC to exit program, Press 'C' to start calibration, Press 'H' to toggle the heatmap",
+    "Do not resize the window manually after created",
+  };
+  const int count = static_cast<int>(sizeof(texts) / sizeof(texts[0]));
+  const int margin = static_cast<int>(50 * render_scale);
+
+  std::vector<sample::drawables::Text> result;
+  for (int i = 0; i < count; ++i) {
+    sample::drawables::Text desc;
+    desc.text = texts[i];
+    if (i == 1)
+      desc.color = {0, 0, 220};
+    desc.fontScale = 1.5 * render_scale;
+    desc.line_type = line_type;
+    desc.org = {margin, rows - margin * (count - i)};
+    result.push_back(desc);
+  }
+  return result;
+}
+
+int maxDifference(const cv::Mat& a, const cv::Mat& b) {
+  int diff = 0;
+  for (int y = 0; y < a.rows; ++y) {
+    const auto* pa = a.ptr(y);
+    const auto* pb = b.ptr(y);
+    for (int x = 0; x < a.cols * 3; ++x)
+      diff = std::max(diff, std::abs(pa[x] - pb[x]));
+  }
+  return diff;
+}
+
+void benchTexts(cv::Size view, double render_scale, int line_type) {
+  const int repeats = 200;
+  const auto texts = helpTexts(render_scale, view.height, line_type);
+  std::printf("%dx%d view, render scale %.1f, %s\n", view.width, view.height, render_scale,
+              line_type == cv::LINE_AA ? "anti-aliased" : "8-connected");
+
+  const cv::Mat background(view, CV_8UC3, cv::Scalar(30, 30, 30));
+  cv::Mat put = background.clone();
+  cv::Mat blended = background.clone();
+
+  const auto put_us = sample::bench::medianMicros(repeats, [&]() {
+    for (const auto& text : texts) {
+      cv::putText(put, text.text, text.org, text.font_face, text.fontScale, text.color,
+                  text.thickness, text.line_type, text.bottom_left_origin);
+    }
+  });
+
+  auto& cache = sample::drawables::TextSpriteCache::forThisThread();
+  const auto miss_us = sample::bench::medianMicros(repeats, [&]() {
+    cache.clear();
+    for (const auto& text : texts)
+      text.draw(&blended);
+  });
+  const auto hit_us = sample::bench::medianMicros(repeats, [&]() {
+    for (const auto& text : texts)
+      text.draw(&blended);
+  });
+
+  // Both drew the same texts over the same background many times
+  put = background.clone();
+  blended = background.clone();
+  for (const auto& text : texts) {
+    cv::putText(put, text.text, text.org, text.font_face, text.fontScale, text.color,
+                text.thickness, text.line_type, text.bottom_left_origin);
+    text.draw(&blended);
+  }
+
+  std::printf("  putText              %8.1f us/draw\n", put_us);
+  std::printf("  sprites, first draw  %8.1f us/draw\n", miss_us);
+  std::printf("  sprites, cached      %8.1f us/draw (%.1fx), max pixel difference %d\n",
+              hit_us, put_us / hit_us, maxDifference(put, blended));
+}
+
+} // namespace
+
+int main() {
+  benchTexts({1920, 1080}, 1.0, cv::LINE_8);
+  benchTexts({1920, 1080}, 1.0, cv::LINE_AA);
+  benchTexts({960, 540}, 0.5, cv::LINE_8);
+  return 0;
+}
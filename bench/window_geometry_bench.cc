@@ -0,0 +1,76 @@
+/**
+ * Cost of mapping one gaze sample into the window: asking the window manager with
+ * eyedid::getWindowPosition / getWindowRect, as the trackers did per sample, against
+ * reading the WindowGeometry cache.
+ *
+ * Opens a HighGUI window to query, so it needs a display. The cache is also read from
+ * another thread while the window's thread keeps moving the window and refreshing the
+ * cache, the worst case for the seqlock readers.
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "opencv2/opencv.hpp"
+
+#include "eyedid/util/display.h"
+
+#include "bench.h"
+#include "window_geometry.h"
+
+namespace {
+
+const char* const kWindowName = "window_geometry_bench";
+
+template<typename F>
+void report(const char* name, int calls, F&& fn) {
+  std::printf("  %-36s %10.1f ns/sample\n", name, sample::bench::batchNanos(15, calls, fn));
+}
+
+} // namespace
+
+int main() {
+  cv::namedWindow(kWindowName);
+  cv::imshow(kWindowName, cv::Mat(240, 320, CV_8UC3, cv::Scalar(0, 0, 0)));
+  cv::waitKey(100);
+
+  const std::string window_name = kWindowName;
+  sample::WindowGeometry geometry(window_name);
+  geometry.refresh();
+
+  eyedid::Point<long> position;
+  eyedid::Rect rect;
+  std::printf("Window at %.0f,%.0f %.0fx%.0f\n", geometry.rect().x, geometry.rect().y,
+              geometry.rect().width, geometry.rect().height);
+
+  report("eyedid::getWindowPosition", 100, [&]() { position = eyedid::getWindowPosition(window_name); });
+  report("eyedid::getWindowRect", 100, [&]() { rect = eyedid::getWindowRect(window_name); });
+  report("WindowGeometry::position", 100000, [&]() { position = geometry.position(); });
+  report("WindowGeometry::rect", 100000, [&]() { rect = geometry.rect(); });
+
+  // The reader runs on its own thread, like the SDK callback thread
+  std::atomic_bool done{false};
+  double contended_ns = 0;
+  std::thread reader([&]() {
+    eyedid::Rect read;
+    contended_ns = sample::bench::batchNanos(15, 100000, [&]() { read = geometry.rect(); });
+    sample::bench::keep(&read);
+    done.store(true);
+  });
+  for (int step = 0; !done.load(); ++step) {
+    cv::moveWindow(kWindowName, 100 + (step & 1) * 20, 100);
+    cv::waitKey(1);
+    geometry.refresh();
+  }
+  reader.join();
+  const auto stats = geometry.stats();
+  std::printf("  %-36s %10.1f ns/sample (%llu queries, %llu changes meanwhile)\n", "WindowGeometry::rect, refreshing",
+              contended_ns, static_cast<unsigned long long>(stats.queries), static_cast<unsigned long long>(stats.changes));
+
+  sample::bench::keep(&position);
+  sample::bench::keep(&rect);
+  cv::destroyWindow(kWindowName);
+  return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * Bounded lock-free multi-producer/multi-consumer queue.
+ *
+ * Based on Dmitry Vyukov's bounded MPMC queue. Storage is allocated once in the
+ * constructor, so push and pop never touch the heap.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_BOUNDED_QUEUE_H_
+#define EYEDID_CPP_SAMPLE_BOUNDED_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace sample {
+
+template<typename T>
+class bounded_queue {
+ public:
+  /**
+   * @param capacity rounded up to the next power of two
+   */
+  explicit bounded_queue(std::size_t capacity) {
+    std::size_t size = 2;
+    while (size < capacity)
+      size <<= 1;
+
+    mask_ = size - 1;
+    cells_.reset(new cell[size]);
+    for (std::size_t i = 0; i < size; ++i)
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  bounded_queue(const bounded_queue&) = delete;
+  bounded_queue& operator=(const bounded_queue&) = delete;
+
+  std::size_t capacity() const { return mask_ + 1; }
+
+  /**
+   * @return false if the queue is full
+   */
+  template<typename U>
+  bool try_push(U&& value) {
+    cell* c;
+    std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      c = &cells_[pos & mask_];
+      const std::size_t seq = c->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    c->value = std::forward<U>(value);
+    c->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @return false if the queue is empty
+   */
+  bool try_pop(T& value) {
+    cell* c;
+    std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      c = &cells_[pos & mask_];
+      const std::size_t seq = c->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    value = std::move(c->value);
+    c->value = T();
+    c->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  struct cell {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<cell[]> cells_;
+  std::size_t mask_ = 0;
+
+  // Keep producer and consumer positions on separate cache lines.
+  // Padding instead of alignas so that heap allocation needs no over-aligned new in C++11.
+  char pad0_[64];
+  std::atomic<std::size_t> enqueue_pos_{0};
+  char pad1_[64 - sizeof(std::atomic<std::size_t>)];
+  std::atomic<std::size_t> dequeue_pos_{0};
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_BOUNDED_QUEUE_H_
@@ -8,9 +8,19 @@
 #include <thread>
 #include <utility>
 
+#if defined(_WIN32)
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#elif defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
 namespace sample {
 
-CameraThread::CameraThread() {
+CameraThread::CameraThread(std::size_t pool_size) : pool_size_(pool_size) {
   thread_ = std::thread([this](){
     run_impl();
   });
@@ -21,21 +31,24 @@ CameraThread::~CameraThread() {
 }
 
 bool CameraThread::run(int camera_index) {
-  if (camera_index == camera_index_) {
-    resume();
-  }
+  return run(std::unique_ptr<FrameSource>(new OpenCVSource(camera_index, pool_size_)));
+}
 
-  auto lck = pause_wait();
-  camera_index_ = camera_index;
-  if (!check_status())
+bool CameraThread::run(std::unique_ptr<FrameSource> source) {
+  if (!source->open())
     return false;
-  lck.unlock();
+  start(std::move(source));
+  return true;
+}
 
+void CameraThread::start(std::unique_ptr<FrameSource> source) {
+  auto lck = pause_wait();
+  source_ = std::move(source);
+  starved_.store(source_->starved_count(), std::memory_order_relaxed);
+  lck.unlock();
 
   pause_ = false;
   cv_.notify_all();
-
-  return true;
 }
 
 void CameraThread::pause() {
@@ -66,8 +79,17 @@ void CameraThread::run_impl() {
     if (stop_)
       break;
 
-    video_ >> frame_;
-    on_frame_(std::move(frame_));
+    auto frame = source_->read();
+    starved_.store(source_->starved_count(), std::memory_order_relaxed);
+    if (frame.empty()) {
+      if (source_->finished()) {
+        pause_ = true;
+        on_end_();
+      }
+      continue;
+    }
+
+    on_frame_(frame);
   }
 }
 
@@ -79,17 +101,27 @@ void CameraThread::join() {
     thread_.join();
 }
 
-bool CameraThread::check_status() {
-  video_.open(camera_index_);
-  if (!video_.isOpened()) {
-    std::cerr << "Failed to open camera\n";
+bool CameraThread::pin(int cpu) {
+  if (cpu < 0 || !thread_.joinable())
     return false;
-  } else if ((video_ >> frame_, frame_.empty())) {
-    std::cerr << "Camera is opened, but failed to get a frame. Try changing the camera_index\n";
+#if defined(_WIN32)
+  if (cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8))
     return false;
-  }
+  return SetThreadAffinityMask(thread_.native_handle(), static_cast<DWORD_PTR>(1) << cpu) != 0;
+#elif defined(__linux__)
+  if (cpu >= CPU_SETSIZE)
+    return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(thread_.native_handle(), sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
 
-  return true;
+std::uint64_t CameraThread::starved_count() const {
+  return starved_.load(std::memory_order_relaxed);
 }
 
 } // namespace sample
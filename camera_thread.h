@@ -6,12 +6,17 @@
 #define EYEDID_CPP_SAMPLE_CAMERA_THREAD_H_
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 
 #include "opencv2/opencv.hpp"
 
+#include "frame_pool.h"
+#include "frame_source.h"
 #include "simple_signal.h"
 
 namespace sample {
@@ -19,29 +24,58 @@ namespace sample {
 /**
  * A handler that runs camera in concurrent thread.
  * Use on_frame_ to add or remove frame listeners
+ *
+ * Frames are read from a FrameSource whose buffers are recycled. Listeners run on the
+ * capture thread, so they should only hand the Frame over (e.g. to a FrameConsumer) and return.
  */
 class CameraThread {
  public:
-  CameraThread();
+  explicit CameraThread(std::size_t pool_size = 8);
   ~CameraThread();
 
+  /** Open a camera with cv::VideoCapture */
   bool run(int camera_index = 0);
 
+  /**
+   * Open and run the given source.
+   * Do not replace a source while listeners still hold its frames.
+   */
+  bool run(std::unique_ptr<FrameSource> source);
+
+  /**
+   * Run a source that is already open, e.g. opened on another thread during startup.
+   * Do not replace a source while listeners still hold its frames.
+   */
+  void start(std::unique_ptr<FrameSource> source);
+
   void resume();
   void pause();
 
   void join();
 
-  signal<void(cv::Mat frame)> on_frame_;
+  /**
+   * Restrict the capture thread to one CPU core.
+   * @return false if the core does not exist or pinning is not supported on this platform
+   */
+  bool pin(int cpu);
+
+  /**
+   * Number of frames grabbed and discarded because every buffer was in use.
+   * Safe to call from any thread: the capture thread copies the source's count after each read.
+   */
+  std::uint64_t starved_count() const;
+
+  signal<void(const Frame& frame)> on_frame_;
+
+  /** Emitted on the capture thread when a finite source has no more frames. The thread pauses */
+  signal<void()> on_end_;
 
  private:
   void run_impl();
-  bool check_status();
   std::unique_lock<std::mutex> pause_wait();
 
-  int camera_index_ = 0;
-  cv::VideoCapture video_;
-  cv::Mat frame_;
+  std::size_t pool_size_;
+  std::unique_ptr<FrameSource> source_;
 
   std::thread thread_;
   std::atomic_bool pause_{true};
@@ -49,9 +83,9 @@ class CameraThread {
   std::condition_variable cv_;
 
   std::atomic_bool stop_{false};
+  std::atomic<std::uint64_t> starved_{0};
 };
 
 } // namespace sample
 
 #endif // EYEDID_CPP_SAMPLE_CAMERA_THREAD_H_
-
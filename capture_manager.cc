@@ -0,0 +1,90 @@
+#include "capture_manager.h"
+
+#include <iostream>
+#include <utility>
+
+#include "color_convert.h"
+#include "timestamp.h"
+
+namespace sample {
+
+CaptureManager::CaptureManager(std::string license_key, const EyedidTrackerOptions& options, FramePolicy policy)
+  : license_key_(std::move(license_key)), options_(options), policy_(policy) {}
+
+CaptureManager::~CaptureManager() {
+  stop();
+}
+
+void CaptureManager::addCamera(std::unique_ptr<FrameSource> source, int cpu) {
+  std::unique_ptr<Pipeline> pipeline(new Pipeline());
+  pipeline->source = std::move(source);
+  pipeline->cpu = cpu;
+  pipeline->tracker = std::make_shared<TrackerManager>();
+
+  // Each camera converts into its own buffer, so trackers never share memory.
+  // Frames beyond the tracking fps are skipped before paying for the conversion.
+  auto p = pipeline.get();
+  pipeline->consumer = std::make_shared<FrameConsumer>([p](const Frame& frame) {
+    if (!p->tracker->admitFrame(frame.info().timestamp_us))
+      return;
+    toRGB(frame, &p->rgb);
+    p->tracker->addFrame(frame.info().timestamp_us, p->rgb);
+  }, policy_);
+
+  // The tracker is fed before any other listener of the camera
+  pipeline->camera.on_frame_.connect(slot_group::kRealtime, [p](const Frame& frame) {
+    p->captured.fetch_add(1, std::memory_order_relaxed);
+    p->consumer->push(frame);
+  }, pipeline->consumer);
+
+  cameras_.push_back(std::move(pipeline));
+}
+
+bool CaptureManager::initialize(std::size_t index) {
+  return cameras_[index]->tracker->initialize(license_key_, options_);
+}
+
+bool CaptureManager::open(std::size_t index) {
+  if (cameras_[index]->source->open())
+    return true;
+  std::cerr << "Camera " << index << ": failed to open\n";
+  return false;
+}
+
+void CaptureManager::start(std::size_t index) {
+  std::int64_t expected = 0;
+  start_us_.compare_exchange_strong(expected, steadyMicros(), std::memory_order_relaxed);
+
+  auto& pipeline = *cameras_[index];
+  if (pipeline.cpu >= 0 && !pipeline.camera.pin(pipeline.cpu))
+    std::cerr << "Camera " << index << ": failed to pin the capture thread to core " << pipeline.cpu << '\n';
+  pipeline.camera.start(std::move(pipeline.source));
+}
+
+void CaptureManager::stop() {
+  for (auto& pipeline : cameras_)
+    pipeline->camera.join();
+  for (auto& pipeline : cameras_)
+    pipeline->consumer->join();
+}
+
+CameraStats CaptureManager::stats(std::size_t index) const {
+  const auto& pipeline = *cameras_[index];
+
+  CameraStats stats;
+  stats.captured = pipeline.captured.load(std::memory_order_relaxed);
+  stats.starved = pipeline.camera.starved_count();
+  stats.tracker = pipeline.consumer->stats();
+  stats.admission = pipeline.tracker->admission();
+  stats.latency = pipeline.tracker->latency();
+
+  const auto start_us = start_us_.load(std::memory_order_relaxed);
+  const auto elapsed_us = steadyMicros() - start_us;
+  if (start_us != 0 && elapsed_us > 0) {
+    stats.capture_fps = static_cast<double>(stats.captured) * 1e6 / static_cast<double>(elapsed_us);
+    stats.gaze_fps = static_cast<double>(stats.latency.count) * 1e6 / static_cast<double>(elapsed_us);
+  }
+  return stats;
+}
+
+} // namespace sample
@@ -0,0 +1,115 @@
+/**
+ * Captures from several cameras at once, each feeding its own GazeTracker.
+ *
+ * Every camera gets an independent pipeline: a FrameSource with its own buffers,
+ * a CameraThread that can be pinned to a core, a FrameConsumer that converts and
+ * passes frames to the SDK, and a TrackerManager with its own coordinate converter.
+ * Pipelines share nothing, so cameras never wait on each other.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_CAPTURE_MANAGER_H_
+#define EYEDID_CPP_SAMPLE_CAPTURE_MANAGER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "opencv2/opencv.hpp"
+
+#include "camera_thread.h"
+#include "frame_consumer.h"
+#include "frame_source.h"
+#include "latency_stats.h"
+#include "tracker_manager.h"
+
+namespace sample {
+
+struct CameraStats {
+  /** Frames delivered by the source */
+  std::uint64_t captured = 0;
+  /** Frames the source skipped because every buffer was in use */
+  std::uint64_t starved = 0;
+  /** Frames handed to, passed to and dropped before the SDK */
+  FrameConsumerStats tracker;
+  /** Frames skipped before conversion because the SDK would omit them */
+  AdmissionStats admission;
+  /** Mean rates since the first camera started */
+  double capture_fps = 0;
+  double gaze_fps = 0;
+  LatencyStats::Snapshot latency;
+};
+
+class CaptureManager {
+ public:
+  /**
+   * @param license_key  used to initialize every camera's GazeTracker
+   * @param options      tracker options shared by all cameras
+   * @param policy       overflow policy of the frames passed to the SDK
+   */
+  CaptureManager(std::string license_key, const EyedidTrackerOptions& options,
+                 FramePolicy policy = FramePolicy::kLatestOnly);
+  ~CaptureManager();
+
+  CaptureManager(const CaptureManager&) = delete;
+  CaptureManager& operator=(const CaptureManager&) = delete;
+
+  /**
+   * Add a camera. Bring it up with initialize(), open() and start().
+   * Must not be called after any camera started.
+   * @param cpu  core to pin the capture thread to, or -1 to leave it to the scheduler
+   */
+  void addCamera(std::unique_ptr<FrameSource> source, int cpu = -1);
+
+  /**
+   * Authenticate and initialize the camera's GazeTracker.
+   * initialize() and open() may run concurrently, also for different cameras.
+   */
+  bool initialize(std::size_t index);
+
+  /** Open the camera's source and wait for its first frame */
+  bool open(std::size_t index);
+
+  /**
+   * Start capturing from a camera that was initialized and opened.
+   * Connect listeners to camera() and tracker() before calling this.
+   */
+  void start(std::size_t index);
+
+  /** Stop capturing and wait until every frame in flight is processed. Called by the destructor */
+  void stop();
+
+  std::size_t size() const { return cameras_.size(); }
+
+  CameraThread& camera(std::size_t index) { return cameras_[index]->camera; }
+  TrackerManager& tracker(std::size_t index) { return *cameras_[index]->tracker; }
+
+  /** Safe to call from any thread */
+  CameraStats stats(std::size_t index) const;
+
+ private:
+  struct Pipeline {
+    std::unique_ptr<FrameSource> source;
+    int cpu = -1;
+
+    // Destroyed from the bottom up: the camera stops before its listeners go away
+    std::shared_ptr<TrackerManager> tracker;
+    std::shared_ptr<FrameConsumer> consumer;
+    cv::Mat rgb;
+    std::atomic<std::uint64_t> captured{0};
+    CameraThread camera;
+  };
+
+  std::string license_key_;
+  EyedidTrackerOptions options_;
+  FramePolicy policy_;
+
+  std::vector<std::unique_ptr<Pipeline>> cameras_;
+  std::atomic<std::int64_t> start_us_{0};
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_CAPTURE_MANAGER_H_
@@ -0,0 +1,508 @@
+#include "color_convert.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define SAMPLE_COLOR_X86 1
+#  include <immintrin.h>
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#    define SAMPLE_TARGET(isa)
+#  else
+#    define SAMPLE_TARGET(isa) __attribute__((target(isa)))
+#  endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#  define SAMPLE_COLOR_NEON 1
+#  include <arm_neon.h>
+#endif
+
+namespace sample {
+
+namespace {
+
+// BT.601 limited range YUV to RGB in 6-bit fixed point.
+// All paths compute the same integer expression, so results do not depend on the CPU:
+//   yy = (Y - 16) * kYG
+//   R  = (yy + kVR * (V - 128) + 32) >> 6
+//   G  = (yy - kVG * (V - 128) - kUG * (U - 128) + 32) >> 6
+//   B  = (yy + kUB * (U - 128) + 32) >> 6
+// Every intermediate fits in int16 except B, which only overflows when the result clamps to 255 anyway.
+const int kYG = 75;   // 1.164
+const int kVR = 102;  // 1.596
+const int kVG = 52;   // 0.813
+const int kUG = 25;   // 0.391
+const int kUB = 129;  // 2.018
+
+using yuyv_row_fn = void (*)(const std::uint8_t* src, std::uint8_t* dst, int width);
+using nv12_row_fn = void (*)(const std::uint8_t* y, const std::uint8_t* uv, std::uint8_t* dst, int width);
+using bgr_row_fn = void (*)(const std::uint8_t* src, std::uint8_t* dst, int width);
+
+/** Scalar */
+inline std::uint8_t clamp8(int v) {
+  return static_cast<std::uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+inline void yuvPixel(int y, int u, int v, std::uint8_t* dst) {
+  const int yy = (y - 16) * kYG;
+  u -= 128;
+  v -= 128;
+  dst[0] = clamp8((yy + kVR * v + 32) >> 6);
+  dst[1] = clamp8((yy - kVG * v - kUG * u + 32) >> 6);
+  dst[2] = clamp8((yy + kUB * u + 32) >> 6);
+}
+
+void yuyvRowScalar(const std::uint8_t* src, std::uint8_t* dst, int width) {
+  int x = 0;
+  for (; x + 1 < width; x += 2, src += 4, dst += 6) {
+    yuvPixel(src[0], src[1], src[3], dst);
+    yuvPixel(src[2], src[1], src[3], dst + 3);
+  }
+  // A lone last pixel has no V sample of its own; treat it as grey chroma
+  if (x < width)
+    yuvPixel(src[0], src[1], 128, dst);
+}
+
+void nv12RowScalar(const std::uint8_t* y, const std::uint8_t* uv, std::uint8_t* dst, int width) {
+  for (int x = 0; x < width; ++x, dst += 3) {
+    const int c = x & ~1;
+    yuvPixel(y[x], uv[c], uv[c + 1], dst);
+  }
+}
+
+void bgrRowScalar(const std::uint8_t* src, std::uint8_t* dst, int width) {
+  for (int x = 0; x < width; ++x, src += 3, dst += 3) {
+    const std::uint8_t b = src[0];
+    dst[0] = src[2];
+    dst[1] = src[1];
+    dst[2] = b;
+  }
+}
+
+#if defined(SAMPLE_COLOR_X86)
+
+bool cpuHasSSE41() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 1);
+  return (info[2] & (1 << 19)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.1") != 0;
+#endif
+}
+
+bool cpuHasAVX2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  __cpuid(info, 1);
+  const bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);
+  if (!os_saves_ymm)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+/** SSE4.1 */
+SAMPLE_TARGET("sse4.1")
+inline void yuvToRGB8SSE41(__m128i y, __m128i u, __m128i v, __m128i* r, __m128i* g, __m128i* b) {
+  const __m128i k32 = _mm_set1_epi16(32);
+  y = _mm_mullo_epi16(_mm_sub_epi16(y, _mm_set1_epi16(16)), _mm_set1_epi16(kYG));
+  u = _mm_sub_epi16(u, _mm_set1_epi16(128));
+  v = _mm_sub_epi16(v, _mm_set1_epi16(128));
+
+  const __m128i vr = _mm_mullo_epi16(v, _mm_set1_epi16(kVR));
+  const __m128i vg = _mm_mullo_epi16(v, _mm_set1_epi16(kVG));
+  const __m128i ug = _mm_mullo_epi16(u, _mm_set1_epi16(kUG));
+  const __m128i ub = _mm_mullo_epi16(u, _mm_set1_epi16(kUB));
+
+  *r = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(y, vr), k32), 6);
+  *g = _mm_srai_epi16(_mm_adds_epi16(_mm_subs_epi16(_mm_subs_epi16(y, vg), ug), k32), 6);
+  *b = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(y, ub), k32), 6);
+}
+
+/** Interleave 16 R, G and B bytes into 48 bytes of packed RGB */
+SAMPLE_TARGET("sse4.1")
+inline void storeRGB16SSE41(__m128i r, __m128i g, __m128i b, std::uint8_t* dst) {
+  const __m128i r0 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+  const __m128i g0 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+  const __m128i b0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+  const __m128i r1 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+  const __m128i g1 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+  const __m128i b1 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+  const __m128i r2 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+  const __m128i g2 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+  const __m128i b2 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+
+  const __m128i out0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r0), _mm_shuffle_epi8(g, g0)),
+                                    _mm_shuffle_epi8(b, b0));
+  const __m128i out1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r1), _mm_shuffle_epi8(g, g1)),
+                                    _mm_shuffle_epi8(b, b1));
+  const __m128i out2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r2), _mm_shuffle_epi8(g, g2)),
+                                    _mm_shuffle_epi8(b, b2));
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), out0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), out1);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 32), out2);
+}
+
+/** 8 YUYV pixels (16 bytes) to R, G, B in int16 lanes */
+SAMPLE_TARGET("sse4.1")
+inline void yuyv8SSE41(__m128i src, __m128i* r, __m128i* g, __m128i* b) {
+  const __m128i y = _mm_and_si128(src, _mm_set1_epi16(0x00FF));
+  const __m128i uv = _mm_srli_epi16(src, 8);           // U0 V0 U1 V1 ...
+  __m128i u = _mm_and_si128(uv, _mm_set1_epi32(0xFFFF)); // U0 0 U1 0 ...
+  __m128i v = _mm_srli_epi32(uv, 16);                  // V0 0 V1 0 ...
+  u = _mm_or_si128(u, _mm_slli_epi32(u, 16));          // U0 U0 U1 U1 ...
+  v = _mm_or_si128(v, _mm_slli_epi32(v, 16));
+  yuvToRGB8SSE41(y, u, v, r, g, b);
+}
+
+SAMPLE_TARGET("sse4.1")
+void yuyvRowSSE41(const std::uint8_t* src, std::uint8_t* dst, int width) {
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    const __m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * x));
+    const __m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * x + 16));
+
+    __m128i r0, g0, b0, r1, g1, b1;
+    yuyv8SSE41(s0, &r0, &g0, &b0);
+    yuyv8SSE41(s1, &r1, &g1, &b1);
+
+    storeRGB16SSE41(_mm_packus_epi16(r0, r1), _mm_packus_epi16(g0, g1), _mm_packus_epi16(b0, b1), dst + 3 * x);
+  }
+  yuyvRowScalar(src + 2 * x, dst + 3 * x, width - x);
+}
+
+SAMPLE_TARGET("sse4.1")
+void nv12RowSSE41(const std::uint8_t* y, const std::uint8_t* uv, std::uint8_t* dst, int width) {
+  const __m128i zero = _mm_setzero_si128();
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    const __m128i yv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x));
+    const __m128i uvv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + x));
+
+    const __m128i u = _mm_and_si128(uvv, _mm_set1_epi16(0x00FF));
+    const __m128i v = _mm_srli_epi16(uvv, 8);
+
+    __m128i r0, g0, b0, r1, g1, b1;
+    yuvToRGB8SSE41(_mm_unpacklo_epi8(yv, zero), _mm_unpacklo_epi16(u, u), _mm_unpacklo_epi16(v, v), &r0, &g0, &b0);
+    yuvToRGB8SSE41(_mm_unpackhi_epi8(yv, zero), _mm_unpackhi_epi16(u, u), _mm_unpackhi_epi16(v, v), &r1, &g1, &b1);
+
+    storeRGB16SSE41(_mm_packus_epi16(r0, r1), _mm_packus_epi16(g0, g1), _mm_packus_epi16(b0, b1), dst + 3 * x);
+  }
+  nv12RowScalar(y + x, uv + x, dst + 3 * x, width - x);
+}
+
+SAMPLE_TARGET("sse4.1")
+void bgrRowSSE41(const std::uint8_t* src, std::uint8_t* dst, int width) {
+  // 5 pixels per 16 byte load. The 16th byte is rewritten by the next iteration or the scalar tail
+  const __m128i swap = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+  int x = 0;
+  for (; x + 6 <= width; x += 5) {
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * x));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * x), _mm_shuffle_epi8(s, swap));
+  }
+  bgrRowScalar(src + 3 * x, dst + 3 * x, width - x);
+}
+
+/** AVX2 */
+SAMPLE_TARGET("avx2")
+inline void yuvToRGB16AVX2(__m256i y, __m256i u, __m256i v, __m256i* r, __m256i* g, __m256i* b) {
+  const __m256i k32 = _mm256_set1_epi16(32);
+  y = _mm256_mullo_epi16(_mm256_sub_epi16(y, _mm256_set1_epi16(16)), _mm256_set1_epi16(kYG));
+  u = _mm256_sub_epi16(u, _mm256_set1_epi16(128));
+  v = _mm256_sub_epi16(v, _mm256_set1_epi16(128));
+
+  const __m256i vr = _mm256_mullo_epi16(v, _mm256_set1_epi16(kVR));
+  const __m256i vg = _mm256_mullo_epi16(v, _mm256_set1_epi16(kVG));
+  const __m256i ug = _mm256_mullo_epi16(u, _mm256_set1_epi16(kUG));
+  const __m256i ub = _mm256_mullo_epi16(u, _mm256_set1_epi16(kUB));
+
+  *r = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(y, vr), k32), 6);
+  *g = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_subs_epi16(_mm256_subs_epi16(y, vg), ug), k32), 6);
+  *b = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(y, ub), k32), 6);
+}
+
+SAMPLE_TARGET("avx2")
+inline void storeRGB32AVX2(__m256i r, __m256i g, __m256i b, std::uint8_t* dst) {
+  storeRGB16SSE41(_mm256_castsi256_si128(r), _mm256_castsi256_si128(g), _mm256_castsi256_si128(b), dst);
+  storeRGB16SSE41(_mm256_extracti128_si256(r, 1), _mm256_extracti128_si256(g, 1), _mm256_extracti128_si256(b, 1),
+                  dst + 48);
+}
+
+/** 16 YUYV pixels (32 bytes) to R, G, B in int16 lanes */
+SAMPLE_TARGET("avx2")
+inline void yuyv16AVX2(__m256i src, __m256i* r, __m256i* g, __m256i* b) {
+  const __m256i y = _mm256_and_si256(src, _mm256_set1_epi16(0x00FF));
+  const __m256i uv = _mm256_srli_epi16(src, 8);
+  __m256i u = _mm256_and_si256(uv, _mm256_set1_epi32(0xFFFF));
+  __m256i v = _mm256_srli_epi32(uv, 16);
+  u = _mm256_or_si256(u, _mm256_slli_epi32(u, 16));
+  v = _mm256_or_si256(v, _mm256_slli_epi32(v, 16));
+  yuvToRGB16AVX2(y, u, v, r, g, b);
+}
+
+SAMPLE_TARGET("avx2")
+void yuyvRowAVX2(const std::uint8_t* src, std::uint8_t* dst, int width) {
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    const __m256i s0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * x));
+    const __m256i s1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * x + 32));
+
+    __m256i r0, g0, b0, r1, g1, b1;
+    yuyv16AVX2(s0, &r0, &g0, &b0);
+    yuyv16AVX2(s1, &r1, &g1, &b1);
+
+    // packus works per 128-bit lane; restore pixel order 0-7, 8-15, 16-23, 24-31
+    const __m256i r = _mm256_permute4x64_epi64(_mm256_packus_epi16(r0, r1), 0xD8);
+    const __m256i g = _mm256_permute4x64_epi64(_mm256_packus_epi16(g0, g1), 0xD8);
+    const __m256i b = _mm256_permute4x64_epi64(_mm256_packus_epi16(b0, b1), 0xD8);
+    storeRGB32AVX2(r, g, b, dst + 3 * x);
+  }
+  yuyvRowSSE41(src + 2 * x, dst + 3 * x, width - x);
+}
+
+SAMPLE_TARGET("avx2")
+void nv12RowAVX2(const std::uint8_t* y, const std::uint8_t* uv, std::uint8_t* dst, int width) {
+  const __m256i zero = _mm256_setzero_si256();
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    const __m256i yv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + x));
+    const __m256i uvv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(uv + x));
+
+    const __m256i u = _mm256_and_si256(uvv, _mm256_set1_epi16(0x00FF));
+    const __m256i v = _mm256_srli_epi16(uvv, 8);
+
+    // Per 128-bit lane, the "lo" halves hold pixels 0-7 | 16-23 and the "hi" halves 8-15 | 24-31,
+    // so packing lo with hi yields pixels in order.
+    __m256i r0, g0, b0, r1, g1, b1;
+    yuvToRGB16AVX2(_mm256_unpacklo_epi8(yv, zero), _mm256_unpacklo_epi16(u, u), _mm256_unpacklo_epi16(v, v),
+                   &r0, &g0, &b0);
+    yuvToRGB16AVX2(_mm256_unpackhi_epi8(yv, zero), _mm256_unpackhi_epi16(u, u), _mm256_unpackhi_epi16(v, v),
+                   &r1, &g1, &b1);
+
+    storeRGB32AVX2(_mm256_packus_epi16(r0, r1), _mm256_packus_epi16(g0, g1), _mm256_packus_epi16(b0, b1),
+                   dst + 3 * x);
+  }
+  nv12RowSSE41(y + x, uv + x, dst + 3 * x, width - x);
+}
+
+#elif defined(SAMPLE_COLOR_NEON)
+
+inline int16x8_t widen(uint8x8_t v) {
+  return vreinterpretq_s16_u16(vmovl_u8(v));
+}
+
+inline void yuvToRGB8NEON(int16x8_t y, int16x8_t u, int16x8_t v, uint8x8_t* r, uint8x8_t* g, uint8x8_t* b) {
+  y = vmulq_n_s16(vsubq_s16(y, vdupq_n_s16(16)), kYG);
+  u = vsubq_s16(u, vdupq_n_s16(128));
+  v = vsubq_s16(v, vdupq_n_s16(128));
+
+  // vqrshrun_n_s16 is the rounding shift and the clamp to [0, 255] in one step
+  *r = vqrshrun_n_s16(vqaddq_s16(y, vmulq_n_s16(v, kVR)), 6);
+  *g = vqrshrun_n_s16(vqsubq_s16(vqsubq_s16(y, vmulq_n_s16(v, kVG)), vmulq_n_s16(u, kUG)), 6);
+  *b = vqrshrun_n_s16(vqaddq_s16(y, vmulq_n_s16(u, kUB)), 6);
+}
+
+void yuyvRowNEON(const std::uint8_t* src, std::uint8_t* dst, int width) {
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    // val[0]: Y of even pixels, val[1]: U, val[2]: Y of odd pixels, val[3]: V
+    const uint8x16x4_t s = vld4q_u8(src + 2 * x);
+
+    uint8x8_t re[2], ge[2], be[2], ro[2], go[2], bo[2];
+    for (int h = 0; h < 2; ++h) {
+      const int16x8_t u = widen(h == 0 ? vget_low_u8(s.val[1]) : vget_high_u8(s.val[1]));
+      const int16x8_t v = widen(h == 0 ? vget_low_u8(s.val[3]) : vget_high_u8(s.val[3]));
+      const int16x8_t ye = widen(h == 0 ? vget_low_u8(s.val[0]) : vget_high_u8(s.val[0]));
+      const int16x8_t yo = widen(h == 0 ? vget_low_u8(s.val[2]) : vget_high_u8(s.val[2]));
+      yuvToRGB8NEON(ye, u, v, &re[h], &ge[h], &be[h]);
+      yuvToRGB8NEON(yo, u, v, &ro[h], &go[h], &bo[h]);
+    }
+
+    const uint8x16x2_t r = vzipq_u8(vcombine_u8(re[0], re[1]), vcombine_u8(ro[0], ro[1]));
+    const uint8x16x2_t g = vzipq_u8(vcombine_u8(ge[0], ge[1]), vcombine_u8(go[0], go[1]));
+    const uint8x16x2_t b = vzipq_u8(vcombine_u8(be[0], be[1]), vcombine_u8(bo[0], bo[1]));
+
+    uint8x16x3_t out0;
+    out0.val[0] = r.val[0];
+    out0.val[1] = g.val[0];
+    out0.val[2] = b.val[0];
+    uint8x16x3_t out1;
+    out1.val[0] = r.val[1];
+    out1.val[1] = g.val[1];
+    out1.val[2] = b.val[1];
+    vst3q_u8(dst + 3 * x, out0);
+    vst3q_u8(dst + 3 * x + 48, out1);
+  }
+  yuyvRowScalar(src + 2 * x, dst + 3 * x, width - x);
+}
+
+void nv12RowNEON(const std::uint8_t* y, const std::uint8_t* uv, std::uint8_t* dst, int width) {
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    const uint8x16_t yv = vld1q_u8(y + x);
+    const uint8x8x2_t uvv = vld2_u8(uv + x);
+    const uint8x8x2_t u = vzip_u8(uvv.val[0], uvv.val[0]);
+    const uint8x8x2_t v = vzip_u8(uvv.val[1], uvv.val[1]);
+
+    uint8x8_t r0, g0, b0, r1, g1, b1;
+    yuvToRGB8NEON(widen(vget_low_u8(yv)), widen(u.val[0]), widen(v.val[0]), &r0, &g0, &b0);
+    yuvToRGB8NEON(widen(vget_high_u8(yv)), widen(u.val[1]), widen(v.val[1]), &r1, &g1, &b1);
+
+    uint8x16x3_t out;
+    out.val[0] = vcombine_u8(r0, r1);
+    out.val[1] = vcombine_u8(g0, g1);
+    out.val[2] = vcombine_u8(b0, b1);
+    vst3q_u8(dst + 3 * x, out);
+  }
+  nv12RowScalar(y + x, uv + x, dst + 3 * x, width - x);
+}
+
+void bgrRowNEON(const std::uint8_t* src, std::uint8_t* dst, int width) {
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    uint8x16x3_t px = vld3q_u8(src + 3 * x);
+    const uint8x16_t b = px.val[0];
+    px.val[0] = px.val[2];
+    px.val[2] = b;
+    vst3q_u8(dst + 3 * x, px);
+  }
+  bgrRowScalar(src + 3 * x, dst + 3 * x, width - x);
+}
+
+#endif
+
+struct Kernels {
+  yuyv_row_fn yuyv;
+  nv12_row_fn nv12;
+  bgr_row_fn bgr;
+  const char* isa;
+};
+
+/** Kernels this CPU can run, slowest first */
+std::vector<Kernels> supportedKernels() {
+  std::vector<Kernels> supported = {{yuyvRowScalar, nv12RowScalar, bgrRowScalar, "scalar"}};
+#if defined(SAMPLE_COLOR_X86)
+  if (cpuHasSSE41()) {
+    supported.push_back({yuyvRowSSE41, nv12RowSSE41, bgrRowSSE41, "sse4.1"});
+    if (cpuHasAVX2())
+      supported.push_back({yuyvRowAVX2, nv12RowAVX2, bgrRowSSE41, "avx2"});
+  }
+#elif defined(SAMPLE_COLOR_NEON)
+  supported.push_back({yuyvRowNEON, nv12RowNEON, bgrRowNEON, "neon"});
+#endif
+  return supported;
+}
+
+Kernels& kernels() {
+  static Kernels k = supportedKernels().back();
+  return k;
+}
+
+} // namespace
+
+void yuyvToRGB(const cv::Mat& src, cv::Mat* dst) {
+  dst->create(src.rows, src.cols, CV_8UC3);
+  const auto yuyv = kernels().yuyv;
+
+  // Whole image as one row when there is no padding, so the vector loop rarely hits a tail
+  if (src.isContinuous() && dst->isContinuous() && src.cols % 2 == 0) {
+    yuyv(src.ptr(), dst->ptr(), src.cols * src.rows);
+    return;
+  }
+  for (int r = 0; r < src.rows; ++r)
+    yuyv(src.ptr(r), dst->ptr(r), src.cols);
+}
+
+void nv12ToRGB(const cv::Mat& src, cv::Mat* dst) {
+  const int height = src.rows * 2 / 3;
+  dst->create(height, src.cols, CV_8UC3);
+  const auto nv12 = kernels().nv12;
+
+  for (int r = 0; r < height; ++r)
+    nv12(src.ptr(r), src.ptr(height + r / 2), dst->ptr(r), src.cols);
+}
+
+void bgrToRGB(const cv::Mat& src, cv::Mat* dst) {
+  dst->create(src.rows, src.cols, CV_8UC3);
+  const auto bgr = kernels().bgr;
+
+  if (src.isContinuous() && dst->isContinuous()) {
+    bgr(src.ptr(), dst->ptr(), src.cols * src.rows);
+    return;
+  }
+  for (int r = 0; r < src.rows; ++r)
+    bgr(src.ptr(r), dst->ptr(r), src.cols);
+}
+
+const char* colorConvertIsa() {
+  return kernels().isa;
+}
+
+std::vector<std::string> colorConvertIsas() {
+  std::vector<std::string> names;
+  for (const auto& k : supportedKernels())
+    names.emplace_back(k.isa);
+  return names;
+}
+
+bool setColorConvertIsa(const std::string& isa) {
+  for (const auto& k : supportedKernels()) {
+    if (isa == k.isa) {
+      kernels() = k;
+      return true;
+    }
+  }
+  return false;
+}
+
+void toBGR(const Frame& frame, cv::Mat* dst) {
+  const auto& src = frame.mat();
+  switch (frame.info().format) {
+    case PixelFormat::kBGR:
+      src.copyTo(*dst);
+      break;
+    case PixelFormat::kYUYV:
+      cv::cvtColor(src, *dst, cv::COLOR_YUV2BGR_YUYV);
+      break;
+    case PixelFormat::kNV12:
+      cv::cvtColor(src, *dst, cv::COLOR_YUV2BGR_NV12);
+      break;
+    case PixelFormat::kMJPEG:
+      cv::imdecode(src, cv::IMREAD_COLOR, dst);
+      break;
+  }
+}
+
+void toRGB(const Frame& frame, cv::Mat* dst) {
+  const auto& src = frame.mat();
+  switch (frame.info().format) {
+    case PixelFormat::kBGR:
+      bgrToRGB(src, dst);
+      break;
+    case PixelFormat::kYUYV:
+      yuyvToRGB(src, dst);
+      break;
+    case PixelFormat::kNV12:
+      nv12ToRGB(src, dst);
+      break;
+    case PixelFormat::kMJPEG: {
+      static thread_local cv::Mat decoded;
+      cv::imdecode(src, cv::IMREAD_COLOR, &decoded);
+      bgrToRGB(decoded, dst);
+      break;
+    }
+  }
+}
+
+} // namespace sample
@@ -0,0 +1,52 @@
+/**
+ * Convert Frames of any PixelFormat to the color layouts the sample needs.
+ *
+ * The *ToRGB kernels convert straight from the camera format to the packed RGB
+ * buffer that eyedid::GazeTracker::addFrame expects, in a single pass over the image.
+ * The fastest implementation (AVX2, SSE4.1, NEON or scalar) is picked at runtime.
+ * Every implementation produces identical output.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_COLOR_CONVERT_H_
+#define EYEDID_CPP_SAMPLE_COLOR_CONVERT_H_
+
+#include <string>
+#include <vector>
+
+#include "opencv2/opencv.hpp"
+
+#include "frame_pool.h"
+
+namespace sample {
+
+/** Convert to 8-bit BGR, e.g. for preview. `dst` is reused if it already has the right geometry */
+void toBGR(const Frame& frame, cv::Mat* dst);
+
+/** Convert to 8-bit RGB as expected by eyedid::GazeTracker::addFrame */
+void toRGB(const Frame& frame, cv::Mat* dst);
+
+/** rows x cols CV_8UC2 YUYV (BT.601 limited range) to rows x cols CV_8UC3 RGB */
+void yuyvToRGB(const cv::Mat& src, cv::Mat* dst);
+
+/** (rows * 3 / 2) x cols CV_8UC1 NV12 (BT.601 limited range) to rows x cols CV_8UC3 RGB */
+void nv12ToRGB(const cv::Mat& src, cv::Mat* dst);
+
+/** rows x cols CV_8UC3 BGR to rows x cols CV_8UC3 RGB */
+void bgrToRGB(const cv::Mat& src, cv::Mat* dst);
+
+/** Name of the instruction set the kernels dispatched to, e.g. "avx2" */
+const char* colorConvertIsa();
+
+/** Instruction sets this CPU can run, slowest first, e.g. {"scalar", "sse4.1", "avx2"} */
+std::vector<std::string> colorConvertIsas();
+
+/**
+ * Use the kernels of another supported instruction set, e.g. to compare them.
+ * Not thread safe: call while no conversion is running.
+ * @return false if `isa` is not in colorConvertIsas()
+ */
+bool setColorConvertIsa(const std::string& isa);
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_COLOR_CONVERT_H_
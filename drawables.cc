@@ -0,0 +1,266 @@
+#include "drawables.h"
+
+#include <cmath>
+
+namespace sample {
+namespace drawables {
+
+/** TextSpriteCache */
+TextSpriteCache& TextSpriteCache::forThisThread() {
+  thread_local TextSpriteCache cache;
+  return cache;
+}
+
+static std::string spriteKey(const Text& text) {
+  std::string key = text.text;
+  key.push_back('\0');
+  const auto append = [&key](const void* value, std::size_t size) {
+    key.append(static_cast<const char*>(value), size);
+  };
+  append(&text.font_face, sizeof(text.font_face));
+  append(&text.fontScale, sizeof(text.fontScale));
+  append(&text.thickness, sizeof(text.thickness));
+  append(&text.line_type, sizeof(text.line_type));
+  append(&text.bottom_left_origin, sizeof(text.bottom_left_origin));
+  return key;
+}
+
+const TextSpriteCache::Sprite& TextSpriteCache::sprite(const Text& text) {
+  auto key = spriteKey(text);
+  const auto found = index_.find(key);
+  if (found != index_.end()) {
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, found->second);
+    return found->second->sprite;
+  }
+  ++stats_.misses;
+
+  // White on black, so the pixel values are the coverage putText would blend with
+  const auto bounds = text.bounds();
+  Entry entry;
+  entry.key = key;
+  entry.sprite.org = text.org - bounds.tl();
+  entry.sprite.mask = cv::Mat::zeros(bounds.size(), CV_8U);
+  cv::putText(entry.sprite.mask, text.text, entry.sprite.org, text.font_face, text.fontScale,
+              cv::Scalar(255), text.thickness, text.line_type, text.bottom_left_origin);
+  stats_.bytes += entry.sprite.mask.total();
+  entries_.push_front(std::move(entry));
+  index_[std::move(key)] = entries_.begin();
+
+  evict();
+  return entries_.front().sprite;
+}
+
+void TextSpriteCache::evict() {
+  // The newest sprite stays even if it alone exceeds the capacity
+  while (stats_.bytes > capacity_bytes_ && entries_.size() > 1) {
+    const auto& oldest = entries_.back();
+    stats_.bytes -= oldest.sprite.mask.total();
+    index_.erase(oldest.key);
+    entries_.pop_back();
+    ++stats_.evictions;
+  }
+}
+
+void TextSpriteCache::clear() {
+  entries_.clear();
+  index_.clear();
+  stats_.bytes = 0;
+}
+
+/** Text */
+void Text::draw(cv::Mat* dst, cv::Point origin) const {
+  if (dst->type() != CV_8UC3) {
+    cv::putText(*dst, text, org - origin, font_face, fontScale, color, thickness, line_type, bottom_left_origin);
+    return;
+  }
+
+  const auto& sprite = TextSpriteCache::forThisThread().sprite(*this);
+  const auto tl = org - origin - sprite.org;
+  const auto target = cv::Rect(tl, sprite.mask.size()) & cv::Rect(0, 0, dst->cols, dst->rows);
+  if (target.empty())
+    return;
+  const cv::Point src = target.tl() - tl;
+
+  const int c[3] = {
+    static_cast<int>(color[0]), static_cast<int>(color[1]), static_cast<int>(color[2]) };
+  for (int y = 0; y < target.height; ++y) {
+    const auto* a = sprite.mask.ptr(src.y + y) + src.x;
+    auto* d = dst->ptr(target.y + y) + 3 * target.x;
+    for (int x = 0; x < target.width; ++x, d += 3) {
+      if (a[x] == 0)
+        continue;
+      // 0..255 coverage to 0..256 weight, so full coverage is exactly the color
+      const int w = a[x] + (a[x] >> 7);
+      for (int k = 0; k < 3; ++k)
+        d[k] = static_cast<std::uint8_t>(d[k] + (((c[k] - d[k]) * w) >> 8));
+    }
+  }
+}
+
+/** Heatmap */
+constexpr int Heatmap::kTile;
+
+void Heatmap::reset(cv::Rect area, double sigma, double half_life_ms) {
+  area_ = area;
+  half_life_us_ = half_life_ms * 1000;
+
+  // Cut off at 3 sigma, 1 at the center so that `saturation` counts samples
+  const int r = std::max(1, static_cast<int>(std::ceil(3 * sigma)));
+  kernel_.create(2 * r + 1, 2 * r + 1, CV_32F);
+  for (int y = 0; y < kernel_.rows; ++y) {
+    for (int x = 0; x < kernel_.cols; ++x) {
+      const double d2 = (x - r) * (x - r) + (y - r) * (y - r);
+      kernel_.at<float>(y, x) = static_cast<float>(std::exp(-d2 / (2 * sigma * sigma)));
+    }
+  }
+
+  heat_ = cv::Mat::zeros(area.size(), CV_32F);
+  color_ = cv::Mat::zeros(area.size(), CV_8UC3);
+  alpha_ = cv::Mat::zeros(area.size(), CV_8U);
+
+  tiles_ = {(area.width + kTile - 1) / kTile, (area.height + kTile - 1) / kTile};
+  const auto count = static_cast<std::size_t>(tiles_.area());
+  tile_time_.assign(count, 0);
+  tile_peak_.assign(count, 0);
+  tile_dirty_.assign(count, 0);
+  dirty_.clear();
+  ++generation_;
+}
+
+cv::Rect Heatmap::tilesOf(const cv::Rect& rect) const {
+  const int x0 = rect.x / kTile;
+  const int y0 = rect.y / kTile;
+  const int x1 = (rect.x + rect.width - 1) / kTile;
+  const int y1 = (rect.y + rect.height - 1) / kTile;
+  return {x0, y0, x1 - x0 + 1, y1 - y0 + 1};
+}
+
+cv::Rect Heatmap::tileRect(int tx, int ty) const {
+  return cv::Rect(tx * kTile, ty * kTile, kTile, kTile) & cv::Rect(0, 0, heat_.cols, heat_.rows);
+}
+
+void Heatmap::markDirty(int tx, int ty) {
+  tile_dirty_[static_cast<std::size_t>(ty * tiles_.width + tx)] = 1;
+}
+
+void Heatmap::decayTile(int tx, int ty, std::int64_t now_us) {
+  const auto index = static_cast<std::size_t>(ty * tiles_.width + tx);
+  auto& peak = tile_peak_[index];
+  auto& time = tile_time_[index];
+  if (peak == 0) {
+    time = now_us;
+    return;
+  }
+  if (now_us <= time)
+    return;
+
+  const auto factor = std::exp2(-static_cast<double>(now_us - time) / half_life_us_);
+  time = now_us;
+  auto tile = heat_(tileRect(tx, ty));
+  // Below one color step the tile looks empty; clear it so it is skipped from now on
+  if (peak * factor < saturation / 255) {
+    tile.setTo(cv::Scalar(0));
+    peak = 0;
+  }
+  else {
+    tile.convertTo(tile, -1, factor);
+    peak = static_cast<float>(peak * factor);
+  }
+  markDirty(tx, ty);
+}
+
+void Heatmap::add(cv::Point point, std::int64_t timestamp_us, float weight) {
+  if (heat_.empty())
+    return;
+
+  const int r = kernel_.cols / 2;
+  const cv::Rect spot(point - area_.tl() - cv::Point(r, r), kernel_.size());
+  const auto target = spot & cv::Rect(0, 0, heat_.cols, heat_.rows);
+  if (target.empty())
+    return;
+
+  // Bring the covered tiles up to date first, so that all heat in a tile shares one timestamp
+  const auto tiles = tilesOf(target);
+  for (int ty = tiles.y; ty < tiles.y + tiles.height; ++ty) {
+    for (int tx = tiles.x; tx < tiles.x + tiles.width; ++tx) {
+      decayTile(tx, ty, timestamp_us);
+      tile_peak_[static_cast<std::size_t>(ty * tiles_.width + tx)] += weight;
+      markDirty(tx, ty);
+    }
+  }
+
+  // Vectorized by OpenCV
+  auto dst = heat_(target);
+  cv::scaleAdd(kernel_(cv::Rect(target.tl() - spot.tl(), target.size())), weight, dst, dst);
+}
+
+void Heatmap::update(std::int64_t now_us) {
+  dirty_.clear();
+  if (heat_.empty())
+    return;
+
+  // Fade tiles nobody looked at recently in steps small enough to look smooth
+  const auto refresh_us = static_cast<std::int64_t>(half_life_us_ / 8);
+  for (int ty = 0; ty < tiles_.height; ++ty) {
+    for (int tx = 0; tx < tiles_.width; ++tx) {
+      const auto index = static_cast<std::size_t>(ty * tiles_.width + tx);
+      if (tile_peak_[index] > 0 && now_us - tile_time_[index] >= refresh_us)
+        decayTile(tx, ty, now_us);
+    }
+  }
+
+  // Recolor dirty tiles, reported as one region per run of dirty tiles in a row
+  for (int ty = 0; ty < tiles_.height; ++ty) {
+    cv::Rect run;
+    for (int tx = 0; tx <= tiles_.width; ++tx) {
+      const auto index = static_cast<std::size_t>(ty * tiles_.width + tx);
+      if (tx < tiles_.width && tile_dirty_[index]) {
+        tile_dirty_[index] = 0;
+        const auto rect = tileRect(tx, ty);
+        run = run.empty() ? rect : (run | rect);
+        continue;
+      }
+      if (run.empty())
+        continue;
+
+      auto alpha = alpha_(run);
+      heat_(run).convertTo(alpha, CV_8U, 255.0 / saturation);
+      auto color = color_(run);
+      cv::applyColorMap(alpha, color, cv::COLORMAP_JET);
+      dirty_.push_back(cv::Rect(run.tl() + area_.tl(), run.size()));
+      run = cv::Rect();
+    }
+  }
+
+  if (!dirty_.empty())
+    ++generation_;
+}
+
+void Heatmap::draw(cv::Mat* dst, cv::Point origin) const {
+  if (heat_.empty())
+    return;
+
+  const auto target = cv::Rect(area_.tl() - origin, area_.size()) & cv::Rect(0, 0, dst->cols, dst->rows);
+  if (target.empty())
+    return;
+  const cv::Point src = target.tl() + origin - area_.tl();
+
+  // Blend in 8-bit fixed point; cold pixels are skipped
+  const int opacity_q8 = static_cast<int>(std::lround(opacity * 256));
+  for (int y = 0; y < target.height; ++y) {
+    const auto* a = alpha_.ptr(src.y + y) + src.x;
+    const auto* c = color_.ptr(src.y + y) + 3 * src.x;
+    auto* d = dst->ptr(target.y + y) + 3 * target.x;
+    for (int x = 0; x < target.width; ++x, c += 3, d += 3) {
+      const int w = (a[x] * opacity_q8) >> 8;
+      if (w == 0)
+        continue;
+      for (int k = 0; k < 3; ++k)
+        d[k] = static_cast<std::uint8_t>(d[k] + (((c[k] - d[k]) * w) >> 8));
+    }
+  }
+}
+
+} // namespace drawables
+} // namespace sample
@@ -6,11 +6,16 @@
 #define EYEDID_CPP_SAMPLE_DRAWABLES_H_
 
 #include <algorithm>
-#include <mutex>
-#include <memory>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <list>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "opencv2/opencv.hpp"
 
@@ -19,6 +24,10 @@
  *
  * Non-static method `draw` does not check its visibility.
  * Use `draw_if` to draw with visibility checking
+ *
+ * `draw` takes the position of `dst` in view coordinates, so an element can be
+ * drawn into a sub-region of the view. `bounds` is the area an element may touch,
+ * and `sameLook` tells whether two states of an element draw the same pixels.
  */
 
 namespace sample {
@@ -30,10 +39,28 @@ struct DrawableBase {
 struct Circle : protected DrawableBase {
   using DrawableBase::visible;
 
-  void draw(cv::Mat* dst) const {
-    cv::circle(*dst, center, radius, color, thickness, line_type, shift);
+  void draw(cv::Mat* dst, cv::Point origin = {}) const {
+    const cv::Point offset(origin.x * (1 << shift), origin.y * (1 << shift));
+    cv::circle(*dst, center - offset, radius, color, thickness, line_type, shift);
+  }
+
+  cv::Rect bounds() const {
+    const auto scale = 1 << shift;
+    // Anti-aliased edges may bleed one more pixel
+    const auto r = (radius + scale - 1) / scale + (thickness > 0 ? thickness : 0) + 2;
+    // A fractional center may round either way
+    const auto x = static_cast<int>(std::floor(static_cast<double>(center.x) / scale));
+    const auto y = static_cast<int>(std::floor(static_cast<double>(center.y) / scale));
+    return {x - r, y - r, 2 * r + 2, 2 * r + 2};
+  }
+
+  bool sameLook(const Circle& other) const {
+    return visible == other.visible && center == other.center && radius == other.radius &&
+           color == other.color && thickness == other.thickness &&
+           line_type == other.line_type && shift == other.shift;
   }
 
+  /** center and radius are in units of 1 / (1 << shift) pixels */
   cv::Point center;
   int radius = 10;
   cv::Scalar color;
@@ -42,30 +69,132 @@ struct Circle : protected DrawableBase {
   int shift = 0;
 };
 
+/**
+ * Draws `buffer` scaled to `size`.
+ *
+ * The scaled image is cached and only recomputed when `size` changes or the buffer is
+ * marked as changed with invalidate(), so redrawing an unchanged frame is a plain copy.
+ * A buffer that already has the target size is copied without scaling.
+ */
 struct Image : protected DrawableBase {
   using DrawableBase::visible;
 
-  void draw(cv::Mat* dst) const {
+  void draw(cv::Mat* dst, cv::Point origin = {}) const {
     if (buffer.empty()) return;
 
-    cv::resize(buffer, resized_, size);
-    const auto img_w = std::min(resized_.cols, dst->cols - tl.x);
-    const auto img_h = std::min(resized_.rows, dst->rows - tl.y);
-    resized_(cv::Rect(0, 0, img_w, img_h)).copyTo((*dst)(cv::Rect(tl.x, tl.y, img_w, img_h)));
+    const cv::Mat* src = &buffer;
+    if (buffer.size() != size) {
+      if (scaled_generation_ != generation_ || scaled_.size() != size) {
+        cv::resize(buffer, scaled_, size);
+        scaled_generation_ = generation_;
+      }
+      src = &scaled_;
+    }
+
+    const auto target = cv::Rect(tl - origin, src->size()) & cv::Rect(0, 0, dst->cols, dst->rows);
+    if (target.empty()) return;
+    const cv::Rect source(target.tl() - (tl - origin), target.size());
+    (*src)(source).copyTo((*dst)(target));
   }
+
+  cv::Rect bounds() const { return {tl, size}; }
+
+  bool sameLook(const Image& other) const {
+    return visible == other.visible && tl == other.tl && size == other.size &&
+           generation_ == other.generation_ && buffer.data == other.buffer.data;
+  }
+
+  /** Call after changing the contents of `buffer` */
+  void invalidate() { ++generation_; }
+
+  /** Incremented by invalidate() */
+  std::uint64_t generation() const { return generation_; }
+
   cv::Point tl;
   cv::Size size = {100, 100};
   cv::Mat buffer;
 
  private:
-  mutable cv::Mat resized_;
+  std::uint64_t generation_ = 0;
+  mutable std::uint64_t scaled_generation_ = std::numeric_limits<std::uint64_t>::max();
+  mutable cv::Mat scaled_;
+};
+
+struct Text;
+
+/**
+ * Rasterized text, kept as alpha masks so that unchanged text is blended instead of
+ * rendered by cv::putText again. Masks do not depend on the position or the color,
+ * so moving or recoloring text reuses them too.
+ *
+ * The least recently used masks are evicted beyond `capacity_bytes`, so dynamic text
+ * such as a HUD does not grow the cache without bound.
+ * Each drawing thread has its own cache; see forThisThread().
+ */
+class TextSpriteCache {
+ public:
+  struct Stats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::size_t bytes = 0;
+  };
+
+  explicit TextSpriteCache(std::size_t capacity_bytes = 8 << 20) : capacity_bytes_(capacity_bytes) {}
+
+  TextSpriteCache(const TextSpriteCache&) = delete;
+  TextSpriteCache& operator=(const TextSpriteCache&) = delete;
+
+  /** The cache Text::draw uses on the calling thread */
+  static TextSpriteCache& forThisThread();
+
+  struct Sprite {
+    /** CV_8U coverage */
+    cv::Mat mask;
+    /** Position of Text::org in the mask */
+    cv::Point org;
+  };
+
+  /** Rasterize `text` unless cached. Stays valid until the next call */
+  const Sprite& sprite(const Text& text);
+
+  void clear();
+
+  Stats stats() const { return stats_; }
+
+ private:
+  struct Entry {
+    std::string key;
+    Sprite sprite;
+  };
+
+  void evict();
+
+  std::size_t capacity_bytes_;
+  std::list<Entry> entries_;  // most recently used first
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  Stats stats_;
 };
 
 struct Text : protected DrawableBase {
   using DrawableBase::visible;
 
-  void draw(cv::Mat* dst) const {
-    cv::putText(*dst, text, org, font_face, fontScale, color, thickness, line_type, bottom_left_origin);
+  /** Blends the cached mask from TextSpriteCache::forThisThread() */
+  void draw(cv::Mat* dst, cv::Point origin = {}) const;
+
+  cv::Rect bounds() const {
+    int baseline = 0;
+    const auto size = cv::getTextSize(text, font_face, fontScale, thickness, &baseline);
+    const auto pad = thickness + 2;
+    const auto top = bottom_left_origin ? org.y - baseline : org.y - size.height;
+    return {org.x - pad, top - pad, size.width + 2 * pad, size.height + baseline + 2 * pad};
+  }
+
+  bool sameLook(const Text& other) const {
+    return visible == other.visible && org == other.org && text == other.text &&
+           font_face == other.font_face && fontScale == other.fontScale && color == other.color &&
+           thickness == other.thickness && line_type == other.line_type &&
+           bottom_left_origin == other.bottom_left_origin;
   }
 
   cv::Point org;
@@ -78,6 +207,79 @@ struct Text : protected DrawableBase {
   bool bottom_left_origin = false;
 };
 
+/**
+ * Attention heatmap blended over the view.
+ *
+ * Every gaze sample adds a Gaussian kernel to a float accumulation buffer. Heat fades
+ * with `half_life_ms`, but lazily: each tile remembers when it was last decayed and
+ * catches up only when a sample lands on it or update() refreshes it, so no frame
+ * touches every pixel. Only tiles that changed are recolored, and dirty() tells the
+ * view which regions to redraw.
+ *
+ * Call reset() before use.
+ */
+struct Heatmap : protected DrawableBase {
+  using DrawableBase::visible;
+
+  /**
+   * Allocate the buffers and clear the heat.
+   * @param area   where the heatmap is drawn, in view coordinates
+   * @param sigma  kernel spread in pixels
+   */
+  void reset(cv::Rect area, double sigma, double half_life_ms = 3000);
+
+  /**
+   * Splat a sample.
+   * @param point         view coordinates
+   * @param timestamp_us  steady clock time of the sample
+   */
+  void add(cv::Point point, std::int64_t timestamp_us, float weight = 1);
+
+  /**
+   * Decay tiles that were not touched for a while and recolor every changed tile.
+   * Call once per frame, before drawing.
+   */
+  void update(std::int64_t now_us);
+
+  void draw(cv::Mat* dst, cv::Point origin = {}) const;
+
+  cv::Rect bounds() const { return area_; }
+
+  bool sameLook(const Heatmap& other) const {
+    return visible == other.visible && area_ == other.area_ && generation_ == other.generation_;
+  }
+
+  /** Regions recolored by the last update(), in view coordinates */
+  const std::vector<cv::Rect>& dirty() const { return dirty_; }
+
+  /** Heat at which the color saturates, in samples at the kernel center */
+  float saturation = 40;
+  /** Blend factor at full heat, in [0, 1] */
+  double opacity = 0.6;
+
+ private:
+  static constexpr int kTile = 64;
+
+  /** Tile index range covering `rect`, in tile units */
+  cv::Rect tilesOf(const cv::Rect& rect) const;
+  cv::Rect tileRect(int tx, int ty) const;
+  void decayTile(int tx, int ty, std::int64_t now_us);
+  void markDirty(int tx, int ty);
+
+  cv::Rect area_;
+  double half_life_us_ = 3000000;
+  cv::Mat kernel_;  // CV_32F, 1 at the center
+  cv::Mat heat_;    // CV_32F, area size
+  cv::Mat color_;   // CV_8UC3, colormapped heat
+  cv::Mat alpha_;   // CV_8U, blend weight
+  cv::Size tiles_;
+  std::vector<std::int64_t> tile_time_;  // when the heat of a tile was last decayed
+  std::vector<float> tile_peak_;         // upper bound of the heat of a tile
+  std::vector<std::uint8_t> tile_dirty_;
+  std::vector<cv::Rect> dirty_;
+  std::uint64_t generation_ = 0;
+};
+
 template<typename...> using void_t = void;
 
 template<typename T, typename = void>
@@ -91,49 +293,43 @@ struct is_drawable<
 
 template<typename Drawable>
 typename std::enable_if<is_drawable<Drawable>::value>::type
-draw_if(const Drawable& drawable, cv::Mat* dst) {
+draw_if(const Drawable& drawable, cv::Mat* dst, cv::Point origin = {}) {
   if (drawable.visible)
-    drawable.draw(dst);
+    drawable.draw(dst, origin);
 }
 
-// No-own erasure
-class Drawable {
-  struct DrawableInterface {
-    virtual void draw(cv::Mat* dst) const = 0;
-  };
-
-  template<typename T>
-  struct DrawableConcrete : DrawableInterface {
-    explicit DrawableConcrete(T* t) : object_(t) {}
-
-    void draw(cv::Mat* dst) const override {
-      if (object_->visible)
-        object_->draw(dst);
-    }
-
-    T* object_;
-  };
-
-  std::shared_ptr<DrawableInterface> ptr_;
-
-  template<typename T>
-  T* get_ptr() {
-    return dynamic_cast<DrawableConcrete<T>*>(ptr_.get())->object_;
-  }
-
- public:
-  Drawable() = default;
-
-  template<typename T, typename std::enable_if<is_drawable<T>::value, int>::type = 0>
-  explicit Drawable(T* object) : ptr_(std::make_shared<DrawableConcrete<T>>(object)) {}
-
-  template<typename T> T* get_as() { return get_ptr<T>(); }
-  template<typename T> const T* get_as() const { return get_ptr<T>(); }
+/**
+ * Pass the regions that differ between the `drawn` and the current state of an element
+ * to `add`: where it was and where it is now.
+ * @return false if the element looks the same
+ */
+template<typename Drawable, typename F>
+bool forEachChange(const Drawable& now, const Drawable& drawn, F&& add) {
+  if (now.sameLook(drawn))
+    return false;
+  if (drawn.visible)
+    add(drawn.bounds());
+  if (now.visible)
+    add(now.bounds());
+  return true;
+}
 
-  void draw(cv::Mat* dst) const {
-    ptr_->draw(dst);
+/** A heatmap that stays in place only changed where it was recolored */
+template<typename F>
+bool forEachChange(const Heatmap& now, const Heatmap& drawn, F&& add) {
+  if (now.sameLook(drawn))
+    return false;
+  if (now.visible && drawn.visible && now.bounds() == drawn.bounds()) {
+    for (const auto& region : now.dirty())
+      add(region);
+    return true;
   }
-};
+  if (drawn.visible)
+    add(drawn.bounds());
+  if (now.visible)
+    add(now.bounds());
+  return true;
+}
 
 } // namespace drawables
 } // namespace sample
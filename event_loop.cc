@@ -0,0 +1,88 @@
+#include "event_loop.h"
+
+#include <utility>
+
+namespace sample {
+
+event_loop::event_loop(std::size_t capacity) : tasks_(capacity) {}
+
+event_loop::~event_loop() {
+  stop();
+}
+
+void event_loop::start() {
+  stop_.store(false, std::memory_order_relaxed);
+  thread_ = std::thread([this]() {
+    run_impl();
+  });
+}
+
+void event_loop::stop() {
+  {
+    std::lock_guard<std::mutex> lck(mutex_);
+    stop_.store(true, std::memory_order_release);
+  }
+  cv_.notify_all();
+
+  if (thread_.joinable())
+    thread_.join();
+}
+
+bool event_loop::post(task_type task) {
+  if (!tasks_.try_push(std::move(task))) {
+    rejected_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  wake();
+  return true;
+}
+
+std::size_t event_loop::run_pending() {
+  std::size_t count = 0;
+  task_type task;
+  while (tasks_.try_pop(task)) {
+    task();
+    task = task_type();
+    ++count;
+  }
+  return count;
+}
+
+// Same handshake as FrameConsumer: either the loop sees the new task,
+// or post() sees sleeping_ and notifies.
+
+void event_loop::wake() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    cv_.notify_one();
+  }
+}
+
+void event_loop::run_impl() {
+  task_type task;
+  while (!stop_.load(std::memory_order_acquire)) {
+    if (tasks_.try_pop(task)) {
+      task();
+      // Release what the task captured now rather than at the next task
+      task = task_type();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lck(mutex_);
+    sleeping_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (tasks_.try_pop(task)) {
+      sleeping_.store(false, std::memory_order_relaxed);
+      lck.unlock();
+      task();
+      task = task_type();
+      continue;
+    }
+    if (!stop_.load(std::memory_order_acquire))
+      cv_.wait(lck);
+    sleeping_.store(false, std::memory_order_relaxed);
+  }
+}
+
+} // namespace sample
@@ -0,0 +1,72 @@
+/**
+ * Runs posted tasks on one thread, in order.
+ *
+ * post() never blocks: a task is rejected when the queue is full, so a slow loop
+ * cannot stall the thread that posts to it. The loop either runs on a thread of its
+ * own (start()) or is driven by its owner with run_pending().
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_EVENT_LOOP_H_
+#define EYEDID_CPP_SAMPLE_EVENT_LOOP_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "bounded_queue.h"
+#include "inplace_function.h"
+
+namespace sample {
+
+class event_loop {
+ public:
+  using task_type = inplace_function<void()>;
+
+  explicit event_loop(std::size_t capacity = 256);
+  ~event_loop();
+
+  event_loop(const event_loop&) = delete;
+  event_loop& operator=(const event_loop&) = delete;
+
+  /** Run tasks on a new thread until stop() */
+  void start();
+
+  /** Stop the thread started by start(). Tasks still queued are left for run_pending() */
+  void stop();
+
+  /**
+   * Run the tasks posted so far on the calling thread.
+   * Use instead of start(), from one thread only.
+   * @return number of tasks run
+   */
+  std::size_t run_pending();
+
+  /**
+   * May be called from any thread.
+   * @return false if the queue is full and the task was discarded
+   */
+  bool post(task_type task);
+
+  /** Tasks discarded by post() */
+  std::uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+ private:
+  void run_impl();
+  void wake();
+
+  bounded_queue<task_type> tasks_;
+  std::atomic<std::uint64_t> rejected_{0};
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::atomic_bool sleeping_{false};
+  std::atomic_bool stop_{false};
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_EVENT_LOOP_H_
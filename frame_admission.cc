@@ -0,0 +1,72 @@
+#include "frame_admission.h"
+
+#include <algorithm>
+
+namespace sample {
+
+FrameAdmission::FrameAdmission(int fps) {
+  setFps(fps);
+}
+
+void FrameAdmission::setFps(int fps) {
+  const std::int64_t interval_us = fps > 0 ? 1000000 / fps : 0;
+  interval_us_.store(interval_us, std::memory_order_relaxed);
+  // Start out tolerating an eighth of a frame of camera jitter
+  tolerance_us_.store(interval_us / 8, std::memory_order_relaxed);
+}
+
+bool FrameAdmission::admit(std::int64_t timestamp_us) {
+  const auto interval_us = interval_us_.load(std::memory_order_relaxed);
+  const auto tolerance_us = tolerance_us_.load(std::memory_order_relaxed);
+
+  if (interval_us <= 0 || !has_last_ || timestamp_us - last_accepted_us_ >= interval_us - tolerance_us) {
+    admitted_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  skipped_.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void FrameAdmission::report(std::int64_t timestamp_us, bool accepted) {
+  if (!accepted) {
+    rejected_.fetch_add(1, std::memory_order_relaxed);
+    tighten();
+    return;
+  }
+
+  has_last_ = true;
+  last_accepted_us_ = timestamp_us;
+
+  // Probe slowly towards the SDK's limit. A rejection halves the tolerance and it takes
+  // dozens of accepted frames to grow back, so wasted conversions stay rare.
+  const auto interval_us = interval_us_.load(std::memory_order_relaxed);
+  auto tolerance_us = tolerance_us_.load(std::memory_order_relaxed);
+  while (true) {
+    const auto relaxed_us = std::min(tolerance_us + interval_us / 256, interval_us / 2);
+    if (relaxed_us <= tolerance_us ||
+        tolerance_us_.compare_exchange_weak(tolerance_us, relaxed_us, std::memory_order_relaxed))
+      break;
+  }
+}
+
+void FrameAdmission::drop() {
+  dropped_.fetch_add(1, std::memory_order_relaxed);
+  tighten();
+}
+
+void FrameAdmission::tighten() {
+  auto tolerance_us = tolerance_us_.load(std::memory_order_relaxed);
+  while (!tolerance_us_.compare_exchange_weak(tolerance_us, tolerance_us / 2, std::memory_order_relaxed)) {}
+}
+
+AdmissionStats FrameAdmission::stats() const {
+  AdmissionStats stats;
+  stats.admitted = admitted_.load(std::memory_order_relaxed);
+  stats.skipped = skipped_.load(std::memory_order_relaxed);
+  stats.rejected = rejected_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+} // namespace sample
@@ -0,0 +1,70 @@
+/**
+ * Predicts which frames GazeTracker::addFrame will accept.
+ *
+ * The SDK silently omits frames that arrive faster than its tracking fps
+ * (GazeTracker::setTrackingFps). Converting such a frame to RGB is wasted work,
+ * so FrameAdmission mirrors the limit and lets only frames that will be accepted
+ * through. The prediction corrects itself from what the SDK actually did:
+ * a rejected frame makes it stricter, and every accepted frame relaxes it a little,
+ * so it settles just inside the SDK's limit even with a jittery camera.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_FRAME_ADMISSION_H_
+#define EYEDID_CPP_SAMPLE_FRAME_ADMISSION_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace sample {
+
+struct AdmissionStats {
+  /** Frames predicted to be accepted, i.e. converted and passed to the SDK */
+  std::uint64_t admitted = 0;
+  /** Frames skipped before conversion */
+  std::uint64_t skipped = 0;
+  /** Admitted frames that addFrame omitted anyway */
+  std::uint64_t rejected = 0;
+  /** Accepted frames that the SDK reported with OnDrop */
+  std::uint64_t dropped = 0;
+};
+
+class FrameAdmission {
+ public:
+  /** @param fps same value as GazeTracker::setTrackingFps. 0 or less admits every frame */
+  explicit FrameAdmission(int fps = 30);
+
+  void setFps(int fps);
+
+  /**
+   * Whether the frame is expected to be accepted.
+   * admit() and report() must be called from one thread.
+   */
+  bool admit(std::int64_t timestamp_us);
+
+  /** Result of GazeTracker::addFrame for a frame */
+  void report(std::int64_t timestamp_us, bool accepted);
+
+  /** The SDK dropped an accepted frame. May be called from any thread */
+  void drop();
+
+  AdmissionStats stats() const;
+
+ private:
+  void tighten();
+
+  std::atomic<std::int64_t> interval_us_{0};
+  // How much earlier than the nominal interval a frame may arrive and still be admitted
+  std::atomic<std::int64_t> tolerance_us_{0};
+
+  bool has_last_ = false;
+  std::int64_t last_accepted_us_ = 0;
+
+  std::atomic<std::uint64_t> admitted_{0};
+  std::atomic<std::uint64_t> skipped_{0};
+  std::atomic<std::uint64_t> rejected_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_FRAME_ADMISSION_H_
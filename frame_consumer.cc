@@ -0,0 +1,162 @@
+#include "frame_consumer.h"
+
+#include <utility>
+
+namespace sample {
+
+FrameConsumer::FrameConsumer(function_type func, FramePolicy policy, std::size_t queue_size)
+  : func_(std::move(func)),
+    policy_(policy),
+    queue_(policy == FramePolicy::kLatestOnly ? 1 : queue_size) {
+  thread_ = std::thread([this]() {
+    run_impl();
+  });
+}
+
+FrameConsumer::~FrameConsumer() {
+  join();
+}
+
+void FrameConsumer::push(const Frame& frame) {
+  received_.fetch_add(1, std::memory_order_relaxed);
+
+  switch (policy_) {
+    case FramePolicy::kBlock:
+      wait_push(frame);
+      break;
+
+    case FramePolicy::kDropOldest:
+      while (!queue_.try_push(frame)) {
+        Frame oldest;
+        if (queue_.try_pop(oldest))
+          dropped_.fetch_add(1, std::memory_order_relaxed);
+      }
+      break;
+
+    case FramePolicy::kLatestOnly:
+      drop_queued();
+      while (!queue_.try_push(frame))
+        drop_queued();
+      break;
+  }
+
+  wake_consumer();
+}
+
+FrameConsumerStats FrameConsumer::stats() const {
+  FrameConsumerStats stats;
+  stats.received = received_.load(std::memory_order_relaxed);
+  stats.processed = processed_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void FrameConsumer::join() {
+  {
+    std::lock_guard<std::mutex> lck(mutex_);
+    stop_.store(true, std::memory_order_release);
+  }
+  cv_.notify_all();
+  space_cv_.notify_all();
+
+  if (thread_.joinable())
+    thread_.join();
+}
+
+void FrameConsumer::drop_queued() {
+  Frame stale;
+  while (queue_.try_pop(stale)) {
+    stale.release();
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+// sleeping_/blocked_ are paired with a seq_cst fence on both sides:
+// either the waiting side sees the queue change, or the other side sees the flag and notifies.
+
+void FrameConsumer::wake_consumer() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    cv_.notify_one();
+  }
+}
+
+void FrameConsumer::wake_producer() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (blocked_.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    space_cv_.notify_one();
+  }
+}
+
+void FrameConsumer::wait_push(const Frame& frame) {
+  while (!queue_.try_push(frame)) {
+    std::unique_lock<std::mutex> lck(mutex_);
+    blocked_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (queue_.try_push(frame)) {
+      blocked_.store(false, std::memory_order_relaxed);
+      return;
+    }
+    if (stop_.load(std::memory_order_acquire)) {
+      blocked_.store(false, std::memory_order_relaxed);
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    space_cv_.wait(lck);
+    blocked_.store(false, std::memory_order_relaxed);
+  }
+}
+
+bool FrameConsumer::wait_pop(Frame& frame) {
+  while (!queue_.try_pop(frame)) {
+    std::unique_lock<std::mutex> lck(mutex_);
+    sleeping_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (queue_.try_pop(frame)) {
+      sleeping_.store(false, std::memory_order_relaxed);
+      break;
+    }
+    if (stop_.load(std::memory_order_acquire)) {
+      sleeping_.store(false, std::memory_order_relaxed);
+      return false;
+    }
+
+    cv_.wait(lck);
+    sleeping_.store(false, std::memory_order_relaxed);
+  }
+
+  wake_producer();
+  return true;
+}
+
+void FrameConsumer::run_impl() {
+  Frame frame;
+  while (wait_pop(frame)) {
+    if (stop_.load(std::memory_order_acquire))
+      break;
+
+    if (policy_ == FramePolicy::kLatestOnly) {
+      // A newer frame may have arrived while we were waking up
+      Frame newer;
+      while (queue_.try_pop(newer)) {
+        frame = std::move(newer);
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    func_(frame);
+    frame.release();
+    processed_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Return pending buffers to the pool
+  while (queue_.try_pop(frame))
+    frame.release();
+}
+
+} // namespace sample
@@ -0,0 +1,99 @@
+/**
+ * Runs a frame listener on its own thread.
+ *
+ * The capture thread only enqueues a Frame handle; the listener pulls frames
+ * from a bounded queue at its own pace. What happens when the listener falls
+ * behind is chosen per consumer with FramePolicy.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_FRAME_CONSUMER_H_
+#define EYEDID_CPP_SAMPLE_FRAME_CONSUMER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "bounded_queue.h"
+#include "frame_pool.h"
+
+namespace sample {
+
+/**
+ * What a FrameConsumer does with a new frame when its queue is full.
+ */
+enum class FramePolicy {
+  /** Stall the capture thread until the listener catches up. No frame is skipped. */
+  kBlock,
+  /** Discard the oldest queued frame to make room for the new one. */
+  kDropOldest,
+  /** Keep only the newest frame; everything still queued is discarded. */
+  kLatestOnly,
+};
+
+struct FrameConsumerStats {
+  std::uint64_t received = 0;
+  std::uint64_t processed = 0;
+  std::uint64_t dropped = 0;
+};
+
+class FrameConsumer {
+ public:
+  using function_type = std::function<void(const Frame&)>;
+
+  /**
+   * @param func        invoked on the consumer thread for every received frame
+   * @param policy      overflow policy
+   * @param queue_size  number of frames that can wait for `func`. Ignored for kLatestOnly
+   */
+  explicit FrameConsumer(function_type func,
+                         FramePolicy policy = FramePolicy::kDropOldest,
+                         std::size_t queue_size = 2);
+  ~FrameConsumer();
+
+  FrameConsumer(const FrameConsumer&) = delete;
+  FrameConsumer& operator=(const FrameConsumer&) = delete;
+
+  /**
+   * Enqueue a frame according to the policy.
+   * Only blocks with FramePolicy::kBlock.
+   */
+  void push(const Frame& frame);
+
+  void join();
+
+  FramePolicy policy() const { return policy_; }
+
+  FrameConsumerStats stats() const;
+
+ private:
+  void run_impl();
+  bool wait_pop(Frame& frame);
+  void wait_push(const Frame& frame);
+  void wake_consumer();
+  void wake_producer();
+  void drop_queued();
+
+  function_type func_;
+  FramePolicy policy_;
+  bounded_queue<Frame> queue_;
+
+  std::atomic<std::uint64_t> received_{0};
+  std::atomic<std::uint64_t> processed_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::condition_variable space_cv_;
+  std::atomic_bool sleeping_{false};
+  std::atomic_bool blocked_{false};
+  std::atomic_bool stop_{false};
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_FRAME_CONSUMER_H_
@@ -0,0 +1,97 @@
+#include "frame_pool.h"
+
+#include <utility>
+
+namespace sample {
+
+/** Frame */
+Frame::~Frame() {
+  release();
+}
+
+Frame::Frame(const Frame& other) : store_(other.store_), index_(other.index_) {
+  if (store_)
+    store_->retain(index_);
+}
+
+Frame::Frame(Frame&& other) noexcept : store_(other.store_), index_(other.index_) {
+  other.store_ = nullptr;
+}
+
+Frame& Frame::operator=(const Frame& other) {
+  if (this != &other) {
+    if (other.store_)
+      other.store_->retain(other.index_);
+    release();
+    store_ = other.store_;
+    index_ = other.index_;
+  }
+  return *this;
+}
+
+Frame& Frame::operator=(Frame&& other) noexcept {
+  if (this != &other) {
+    release();
+    store_ = other.store_;
+    index_ = other.index_;
+    other.store_ = nullptr;
+  }
+  return *this;
+}
+
+void Frame::release() {
+  if (store_) {
+    store_->unref(index_);
+    store_ = nullptr;
+  }
+}
+
+const cv::Mat& Frame::mat() const {
+  return store_->slots_[index_].mat;
+}
+
+const FrameInfo& Frame::info() const {
+  return store_->slots_[index_].info;
+}
+
+/** FrameStore */
+FrameStore::FrameStore(std::size_t capacity)
+  : capacity_(capacity), slots_(new Slot[capacity]) {}
+
+Frame FrameStore::share(std::uint32_t index) {
+  slots_[index].refs.store(1, std::memory_order_relaxed);
+  return Frame(this, index);
+}
+
+void FrameStore::retain(std::uint32_t index) {
+  slots_[index].refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameStore::unref(std::uint32_t index) {
+  if (slots_[index].refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    recycle(index);
+}
+
+/** FramePool */
+FramePool::FramePool(std::size_t capacity) : FrameStore(capacity), free_(capacity) {
+  for (std::size_t i = 0; i < capacity; ++i)
+    free_.try_push(static_cast<std::uint32_t>(i));
+}
+
+void FramePool::reserve(int rows, int cols, int type) {
+  for (std::size_t i = 0; i < capacity(); ++i)
+    slot(static_cast<std::uint32_t>(i)).mat.create(rows, cols, type);
+}
+
+Frame FramePool::acquire() {
+  std::uint32_t index;
+  if (!free_.try_pop(index))
+    return Frame();
+  return share(index);
+}
+
+void FramePool::recycle(std::uint32_t index) {
+  free_.try_push(index);
+}
+
+} // namespace sample
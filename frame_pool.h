@@ -0,0 +1,158 @@
+/**
+ * Reusable camera frame buffers shared between the capture thread and frame consumers.
+ *
+ * The capture thread fills a buffer and publishes a `Frame` handle.
+ * Consumers hold handles as long as they need the pixels; the buffer goes back
+ * to its FrameStore when the last handle is released, so steady state never allocates.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_FRAME_POOL_H_
+#define EYEDID_CPP_SAMPLE_FRAME_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "opencv2/opencv.hpp"
+
+#include "bounded_queue.h"
+
+namespace sample {
+
+class FrameStore;
+
+/**
+ * Memory layout of Frame::mat()
+ */
+enum class PixelFormat {
+  /** rows x cols, CV_8UC3 */
+  kBGR,
+  /** rows x cols, CV_8UC2 packed Y0 U Y1 V */
+  kYUYV,
+  /** (rows * 3 / 2) x cols, CV_8UC1. Y plane followed by interleaved UV plane */
+  kNV12,
+  /** 1 x bytes, CV_8UC1 compressed JPEG */
+  kMJPEG,
+};
+
+struct FrameInfo {
+  /** Increasing number assigned by the capture source */
+  std::uint64_t sequence = 0;
+  /** Acquisition time in microseconds on the steady clock. See timestamp.h */
+  std::int64_t timestamp_us = 0;
+  PixelFormat format = PixelFormat::kBGR;
+  /** Image size in pixels. May differ from mat().size() depending on the format */
+  cv::Size size;
+};
+
+/**
+ * Reference-counted handle to a frame buffer.
+ * Copying a handle only bumps an atomic counter.
+ *
+ * Do not keep a copy of `mat()` after the handle is released:
+ * the buffer is reused for a later frame.
+ */
+class Frame {
+ public:
+  Frame() = default;
+  ~Frame();
+
+  Frame(const Frame& other);
+  Frame(Frame&& other) noexcept;
+  Frame& operator=(const Frame& other);
+  Frame& operator=(Frame&& other) noexcept;
+
+  void release();
+
+  bool empty() const { return store_ == nullptr; }
+
+  const cv::Mat& mat() const;
+  const FrameInfo& info() const;
+
+ private:
+  friend class FrameStore;
+
+  Frame(FrameStore* store, std::uint32_t index) : store_(store), index_(index) {}
+
+  FrameStore* store_ = nullptr;
+  std::uint32_t index_ = 0;
+};
+
+/**
+ * Owner of a fixed number of buffers that Frame handles refer to.
+ * Subclasses decide how a buffer is recycled once its last handle is released.
+ *
+ * A FrameStore must outlive every Frame it handed out.
+ */
+class FrameStore {
+ public:
+  explicit FrameStore(std::size_t capacity);
+  virtual ~FrameStore() = default;
+
+  FrameStore(const FrameStore&) = delete;
+  FrameStore& operator=(const FrameStore&) = delete;
+
+  std::size_t capacity() const { return capacity_; }
+
+ protected:
+  struct Slot {
+    cv::Mat mat;
+    FrameInfo info;
+    std::atomic_int refs{0};
+  };
+
+  /** Publish a slot as a new Frame holding the only reference */
+  Frame share(std::uint32_t index);
+
+  Slot& slot(std::uint32_t index) { return slots_[index]; }
+  Slot& slot(const Frame& frame) { return slots_[frame.index_]; }
+
+  /** Called when the last Frame referring to the slot is released. May run on any thread */
+  virtual void recycle(std::uint32_t index) = 0;
+
+ private:
+  friend class Frame;
+
+  void retain(std::uint32_t index);
+  void unref(std::uint32_t index);
+
+  std::size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+};
+
+/**
+ * FrameStore whose buffers are plain cv::Mat, preallocated with reserve().
+ */
+class FramePool : public FrameStore {
+ public:
+  explicit FramePool(std::size_t capacity);
+
+  /**
+   * Allocate every buffer with the given geometry up front.
+   * Must not be called while frames are in flight.
+   */
+  void reserve(int rows, int cols, int type);
+
+  /**
+   * Take a free buffer for writing.
+   * @return empty Frame if every buffer is still referenced
+   */
+  Frame acquire();
+
+  /**
+   * Writable buffer and info of a frame that was just acquired and is not yet published.
+   */
+  cv::Mat& buffer(const Frame& frame) { return slot(frame).mat; }
+  FrameInfo& info(const Frame& frame) { return slot(frame).info; }
+
+ protected:
+  void recycle(std::uint32_t index) override;
+
+ private:
+  bounded_queue<std::uint32_t> free_;
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_FRAME_POOL_H_
@@ -0,0 +1,80 @@
+#include "frame_source.h"
+
+#include <iostream>
+
+#include "timestamp.h"
+
+namespace sample {
+
+OpenCVSource::OpenCVSource(int camera_index, std::size_t pool_size)
+  : camera_index_(camera_index), pool_(pool_size) {}
+
+OpenCVSource::~OpenCVSource() {
+  close();
+}
+
+bool OpenCVSource::open() {
+  video_.open(camera_index_);
+  cv::Mat probe;
+  if (!video_.isOpened()) {
+    std::cerr << "Failed to open camera\n";
+    return false;
+  } else if ((video_ >> probe, probe.empty())) {
+    std::cerr << "Camera is opened, but failed to get a frame. Try changing the camera_index\n";
+    return false;
+  }
+
+  pool_.reserve(probe.rows, probe.cols, probe.type());
+  return true;
+}
+
+void OpenCVSource::close() {
+  video_.release();
+}
+
+Frame OpenCVSource::read() {
+  auto frame = pool_.acquire();
+  if (frame.empty()) {
+    // Every buffer is still held by listeners. Drain the driver anyway so that
+    // the next frame we deliver is a fresh one.
+    video_.grab();
+    count_starved();
+    return frame;
+  }
+
+  if (!video_.grab())
+    return Frame();
+  const auto timestamp_us = stamp();
+
+  auto& buffer = pool_.buffer(frame);
+  if (!video_.retrieve(buffer))
+    return Frame();
+
+  auto& info = pool_.info(frame);
+  info.sequence = sequence_++;
+  info.timestamp_us = timestamp_us;
+  info.format = PixelFormat::kBGR;
+  info.size = buffer.size();
+  return frame;
+}
+
+std::int64_t OpenCVSource::stamp() {
+  const auto now_us = steadyMicros();
+  const auto pos_ms = video_.get(cv::CAP_PROP_POS_MSEC);
+  if (pos_ms <= 0)
+    return now_us;
+
+  // The driver clock has an unknown epoch. The smallest (now - pos) seen so far is the best
+  // estimate of the offset between the two clocks; it grows by 1us per frame to follow drift.
+  const auto pos_us = static_cast<std::int64_t>(pos_ms * 1000);
+  const auto offset_us = now_us - pos_us;
+  if (!has_pos_offset_ || offset_us < pos_offset_us_ + 1) {
+    pos_offset_us_ = offset_us;
+    has_pos_offset_ = true;
+  } else {
+    pos_offset_us_ += 1;
+  }
+  return pos_us + pos_offset_us_;
+}
+
+} // namespace sample
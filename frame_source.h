@@ -0,0 +1,82 @@
+/**
+ * Capture backends that CameraThread reads frames from.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_FRAME_SOURCE_H_
+#define EYEDID_CPP_SAMPLE_FRAME_SOURCE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "opencv2/opencv.hpp"
+
+#include "frame_pool.h"
+
+namespace sample {
+
+/**
+ * A device that produces Frames.
+ * The source owns the frame buffers, so it must outlive every Frame it returned.
+ */
+class FrameSource {
+ public:
+  virtual ~FrameSource() = default;
+
+  /**
+   * Open the device and make sure that a frame can be read.
+   * Prints the reason on failure.
+   */
+  virtual bool open() = 0;
+
+  virtual void close() = 0;
+
+  /**
+   * Wait for the next frame.
+   * @return empty Frame if no frame could be delivered this time
+   */
+  virtual Frame read() = 0;
+
+  /** True once a finite source (e.g. a recording) has delivered its last frame */
+  virtual bool finished() const { return false; }
+
+  /** Number of frames discarded because every buffer was still held by listeners */
+  std::uint64_t starved_count() const { return starved_.load(std::memory_order_relaxed); }
+
+ protected:
+  void count_starved() { starved_.fetch_add(1, std::memory_order_relaxed); }
+
+ private:
+  std::atomic<std::uint64_t> starved_{0};
+};
+
+/**
+ * cv::VideoCapture backend. Frames are BGR.
+ *
+ * Frames are stamped with CAP_PROP_POS_MSEC when the backend reports it, mapped onto the
+ * steady clock. Otherwise they are stamped right after grab() returns.
+ */
+class OpenCVSource : public FrameSource {
+ public:
+  explicit OpenCVSource(int camera_index, std::size_t pool_size = 8);
+  ~OpenCVSource() override;
+
+  bool open() override;
+  void close() override;
+  Frame read() override;
+
+ private:
+  std::int64_t stamp();
+
+  int camera_index_;
+  cv::VideoCapture video_;
+  FramePool pool_;
+  std::uint64_t sequence_ = 0;
+
+  bool has_pos_offset_ = false;
+  std::int64_t pos_offset_us_ = 0;
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_FRAME_SOURCE_H_
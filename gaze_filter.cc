@@ -0,0 +1,153 @@
+#include "gaze_filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sample {
+
+constexpr int GazeFilter::kKindCount;
+constexpr int GazeFilter::kMaxWindow;
+
+// Interval assumed for the first point and after a timestamp that went backwards
+static constexpr float kDefaultInterval = 1.0f / 30;
+// Longer gaps than this restart the filter rather than extrapolate over them
+static constexpr float kMaxInterval = 0.5f;
+
+GazeFilter::GazeFilter(const Params& params) {
+  configure(params);
+}
+
+void GazeFilter::configure(const Params& params) {
+  params_ = params;
+  params_.window = std::max(1, std::min(params_.window, kMaxWindow));
+  reset();
+}
+
+void GazeFilter::reset() {
+  started_ = false;
+  sum_ = cv::Point2f();
+  head_ = 0;
+  count_ = 0;
+}
+
+cv::Point2f GazeFilter::filter(cv::Point2f point, std::uint64_t timestamp_ms) {
+  float dt = kDefaultInterval;
+  if (started_ && timestamp_ms > last_ms_)
+    dt = static_cast<float>(timestamp_ms - last_ms_) / 1000;
+  if (dt > kMaxInterval)
+    reset();
+  last_ms_ = timestamp_ms;
+
+  switch (params_.kind) {
+    case Kind::kMean:
+      return mean(point);
+    case Kind::kOneEuro:
+      return oneEuro(point, dt);
+    case Kind::kKalman:
+      return kalman(point, dt);
+    case Kind::kNone:
+      break;
+  }
+  started_ = true;
+  return point;
+}
+
+cv::Point2f GazeFilter::mean(cv::Point2f point) {
+  started_ = true;
+  if (count_ == params_.window)
+    sum_ -= ring_[head_];
+  else
+    ++count_;
+  ring_[head_] = point;
+  sum_ += point;
+
+  // Rounding errors of the running sum would add up over a long session,
+  // so it is recomputed once per lap, O(1) per point on average
+  if (++head_ == params_.window) {
+    head_ = 0;
+    if (count_ == params_.window) {
+      sum_ = cv::Point2f();
+      for (int i = 0; i < count_; ++i)
+        sum_ += ring_[i];
+    }
+  }
+  return sum_ * (1.0f / static_cast<float>(count_));
+}
+
+// Smoothing factor of an exponential filter with this cutoff frequency
+static float smoothing(float cutoff_hz, float dt) {
+  const float tau = 1.0f / (2 * static_cast<float>(CV_PI) * cutoff_hz);
+  return 1.0f / (1.0f + tau / dt);
+}
+
+cv::Point2f GazeFilter::oneEuro(cv::Point2f point, float dt) {
+  if (!started_) {
+    started_ = true;
+    smoothed_ = point;
+    speed_ = cv::Point2f();
+    return point;
+  }
+
+  // One cutoff for both axes, from the speed of the gaze point, so diagonal moves stay straight
+  const auto raw_speed = (point - smoothed_) * (1.0f / dt);
+  const float a_speed = smoothing(params_.speed_cutoff, dt);
+  speed_ += (raw_speed - speed_) * a_speed;
+  const float cutoff = params_.min_cutoff + params_.beta * std::hypot(speed_.x, speed_.y);
+  smoothed_ += (point - smoothed_) * smoothing(cutoff, dt);
+  return smoothed_;
+}
+
+cv::Point2f GazeFilter::kalman(cv::Point2f point, float dt) {
+  const float r = params_.measurement_noise * params_.measurement_noise;
+  const float z[2] = { point.x, point.y };
+  if (!started_) {
+    started_ = true;
+    for (int i = 0; i < 2; ++i) {
+      // Position as measured, velocity unknown
+      axes_[i] = Axis();
+      axes_[i].p = z[i];
+      axes_[i].p00 = r;
+      axes_[i].p11 = 1e8f;
+    }
+    return point;
+  }
+
+  // Piecewise constant acceleration between points
+  const float q = params_.acceleration_noise * params_.acceleration_noise;
+  const float dt2 = dt * dt;
+  const float q00 = q * dt2 * dt2 / 4, q01 = q * dt2 * dt / 2, q11 = q * dt2;
+
+  float out[2];
+  for (int i = 0; i < 2; ++i) {
+    auto& a = axes_[i];
+    // Predict
+    a.p += a.v * dt;
+    a.p00 += dt * (2 * a.p01 + dt * a.p11) + q00;
+    a.p01 += dt * a.p11 + q01;
+    a.p11 += q11;
+
+    // Correct with the measured position
+    const float s = a.p00 + r;
+    const float k0 = a.p00 / s, k1 = a.p01 / s;
+    const float residual = z[i] - a.p;
+    a.p += k0 * residual;
+    a.v += k1 * residual;
+    a.p11 -= k1 * a.p01;
+    a.p01 *= 1 - k0;
+    a.p00 *= 1 - k0;
+    out[i] = a.p;
+  }
+  return { out[0], out[1] };
+}
+
+const char* gazeFilterName(GazeFilter::Kind kind) {
+  switch (kind) {
+    case GazeFilter::Kind::kNone: return "none";
+    case GazeFilter::Kind::kMean: return "mean";
+    case GazeFilter::Kind::kOneEuro: return "one-euro";
+    case GazeFilter::Kind::kKalman: return "kalman";
+  }
+  return "";
+}
+
+} // namespace sample
@@ -0,0 +1,101 @@
+/**
+ * Smoothing of gaze points.
+ *
+ * Raw gaze points jitter by several pixels even while the eyes rest. Every filter trades
+ * that jitter against lag after the eyes move:
+ *  - kMean averages the last `window` points, a fixed lag of (window - 1) / 2 samples.
+ *  - kOneEuro lowers its cutoff frequency at rest and raises it with the gaze speed,
+ *    so fixations are smooth and saccades are followed closely.
+ *  - kKalman tracks position and velocity, assuming constant velocity between samples.
+ *
+ * All state is fixed-size floats: filtering never allocates, and configure() may switch
+ * filters at any time, which only resets the state.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_GAZE_FILTER_H_
+#define EYEDID_CPP_SAMPLE_GAZE_FILTER_H_
+
+#include <cstdint>
+
+#include "opencv2/opencv.hpp"
+
+namespace sample {
+
+class GazeFilter {
+ public:
+  enum class Kind {
+    kNone,
+    kMean,
+    kOneEuro,
+    kKalman,
+  };
+  static constexpr int kKindCount = 4;
+
+  static constexpr int kMaxWindow = 32;
+
+  struct Params {
+    Kind kind = Kind::kMean;
+
+    /** kMean: points averaged, at most kMaxWindow */
+    int window = 3;
+
+    /** kOneEuro: cutoff frequency at rest in Hz, and its increase per px/s of gaze speed */
+    float min_cutoff = 1.0f;
+    float beta = 0.007f;
+    /** kOneEuro: cutoff frequency of the gaze speed estimate in Hz */
+    float speed_cutoff = 1.0f;
+
+    /** kKalman: standard deviation of the gaze acceleration in px/s^2, and of a raw point in px */
+    float acceleration_noise = 4000.0f;
+    float measurement_noise = 10.0f;
+  };
+
+  GazeFilter() = default;
+  explicit GazeFilter(const Params& params);
+
+  /** Use other parameters. Resets the state */
+  void configure(const Params& params);
+  const Params& params() const { return params_; }
+
+  /** Forget past points, e.g. when tracking was lost */
+  void reset();
+
+  /**
+   * @param point         raw gaze point
+   * @param timestamp_ms  time of the point; kOneEuro and kKalman need the interval between points
+   * @return filtered gaze point
+   */
+  cv::Point2f filter(cv::Point2f point, std::uint64_t timestamp_ms);
+
+ private:
+  cv::Point2f mean(cv::Point2f point);
+  cv::Point2f oneEuro(cv::Point2f point, float dt);
+  cv::Point2f kalman(cv::Point2f point, float dt);
+
+  Params params_;
+  bool started_ = false;
+  std::uint64_t last_ms_ = 0;
+
+  // kMean: ring buffer and its running sum
+  cv::Point2f ring_[kMaxWindow];
+  cv::Point2f sum_;
+  int head_ = 0;
+  int count_ = 0;
+
+  // kOneEuro: last output and speed estimate
+  cv::Point2f smoothed_;
+  cv::Point2f speed_;
+
+  // kKalman: position, velocity and the covariance per axis, which is symmetric
+  struct Axis {
+    float p = 0, v = 0;
+    float p00 = 0, p01 = 0, p11 = 0;
+  };
+  Axis axes_[2];
+};
+
+const char* gazeFilterName(GazeFilter::Kind kind);
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_GAZE_FILTER_H_
@@ -0,0 +1,108 @@
+#include "gaze_predictor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sample {
+
+constexpr std::int64_t GazePredictor::kMaxHorizonUs;
+constexpr int GazePredictor::kPending;
+
+// Weight of the newest velocity sample; lower is smoother but slower to follow
+static constexpr float kVelocitySmoothing = 0.5f;
+// Points further apart than this do not give a velocity
+static constexpr std::int64_t kMaxIntervalUs = 200000;
+// Time constant of the velocity decay assumed during a saccade
+static constexpr float kSaccadeDecayUs = 20000;
+
+void GazePredictor::reset() {
+  started_ = false;
+  velocity_ = cv::Point2f();
+  pending_count_ = 0;
+}
+
+cv::Point2f GazePredictor::predict(cv::Point2f point, std::int64_t timestamp_us, EyedidEyeMovementState movement,
+                                   std::int64_t target_us) {
+  check(point, timestamp_us);
+
+  const auto interval_us = timestamp_us - last_us_;
+  if (!started_ || interval_us <= 0 || interval_us > kMaxIntervalUs) {
+    velocity_ = cv::Point2f();
+  }
+  else {
+    const auto velocity = (point - last_point_) * (1.0f / static_cast<float>(interval_us));
+    velocity_ += (velocity - velocity_) * kVelocitySmoothing;
+  }
+  started_ = true;
+  last_point_ = point;
+  last_us_ = timestamp_us;
+
+  const auto horizon_us = std::max<std::int64_t>(0, std::min(target_us - timestamp_us, kMaxHorizonUs));
+  const auto horizon = static_cast<float>(horizon_us);
+  cv::Point2f predicted = point;
+  switch (movement) {
+    case kEyedidEyeMovementFixation:
+      // A resting eye does not move on; extrapolating its jitter would only add to it
+      break;
+    case kEyedidEyeMovementSaccade:
+    case kEyedidEyeMovementUnknown:
+      // Saccades brake into the next fixation; follow a velocity that decays exponentially.
+      // Unclassified points are the least reliable, so they get no more than that
+      predicted += velocity_ * (kSaccadeDecayUs * (1 - std::exp(-horizon / kSaccadeDecayUs)));
+      break;
+    default:
+      // A state this predictor does not know: hold the point, like a fixation
+      break;
+  }
+
+  if (pending_count_ == kPending) {
+    pending_head_ = (pending_head_ + 1) % kPending;
+    --pending_count_;
+  }
+  auto& pending = pending_[(pending_head_ + pending_count_) % kPending];
+  pending.target_us = timestamp_us + horizon_us;
+  pending.horizon_us = horizon_us;
+  pending.predicted = predicted;
+  pending.held = point;
+  ++pending_count_;
+
+  return enabled_.load(std::memory_order_relaxed) ? predicted : point;
+}
+
+void GazePredictor::check(cv::Point2f point, std::int64_t timestamp_us) {
+  while (pending_count_ > 0) {
+    const auto& pending = pending_[pending_head_];
+    if (pending.target_us > timestamp_us)
+      break;
+
+    // The gaze at the target time, between the last point and this one
+    cv::Point2f truth = point;
+    if (started_ && timestamp_us > last_us_ && pending.target_us > last_us_) {
+      const float t = static_cast<float>(pending.target_us - last_us_) / static_cast<float>(timestamp_us - last_us_);
+      truth = last_point_ + (point - last_point_) * t;
+    }
+    const auto error = pending.predicted - truth;
+    const auto hold_error = pending.held - truth;
+    error_sum_.fetch_add(std::llround(std::hypot(error.x, error.y) * 100), std::memory_order_relaxed);
+    hold_error_sum_.fetch_add(std::llround(std::hypot(hold_error.x, hold_error.y) * 100), std::memory_order_relaxed);
+    horizon_sum_us_.fetch_add(pending.horizon_us, std::memory_order_relaxed);
+    checked_.fetch_add(1, std::memory_order_relaxed);
+
+    pending_head_ = (pending_head_ + 1) % kPending;
+    --pending_count_;
+  }
+}
+
+GazePredictor::Stats GazePredictor::stats() const {
+  Stats stats;
+  stats.checked = checked_.load(std::memory_order_relaxed);
+  if (stats.checked == 0)
+    return stats;
+  const auto count = static_cast<double>(stats.checked);
+  stats.mean_horizon_us = static_cast<double>(horizon_sum_us_.load(std::memory_order_relaxed)) / count;
+  stats.mean_error_px = static_cast<double>(error_sum_.load(std::memory_order_relaxed)) / 100 / count;
+  stats.mean_hold_error_px = static_cast<double>(hold_error_sum_.load(std::memory_order_relaxed)) / 100 / count;
+  return stats;
+}
+
+} // namespace sample
@@ -0,0 +1,93 @@
+/**
+ * Extrapolates gaze points to the time they will be seen.
+ *
+ * A gaze point reaches the screen only after capture, tracking and rendering, so a
+ * moving eye is drawn where it was, not where it is. The predictor moves each point
+ * along its recent velocity to the expected present time. Fixations are never moved,
+ * so the point stays still while the eyes rest. Saccades and unclassified points follow
+ * a decaying velocity, so they move at most a short step ahead.
+ *
+ * Every prediction is checked against the points that arrive later. The error of simply
+ * showing the latest point is tracked as well, as the baseline prediction has to beat.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_GAZE_PREDICTOR_H_
+#define EYEDID_CPP_SAMPLE_GAZE_PREDICTOR_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "eyedid/gaze_tracker.h"
+
+#include "opencv2/opencv.hpp"
+
+namespace sample {
+
+class GazePredictor {
+ public:
+  struct Stats {
+    /** Predictions checked against a later point */
+    std::uint64_t checked = 0;
+    double mean_horizon_us = 0;
+    /** Mean distance between predictions and the points measured at their target time */
+    double mean_error_px = 0;
+    /** The same for the latest point as is, i.e. without prediction */
+    double mean_hold_error_px = 0;
+  };
+
+  /** Never extrapolate further ahead than this */
+  static constexpr std::int64_t kMaxHorizonUs = 150000;
+
+  /** Whether predict() moves points. When disabled, predictions are still made and checked */
+  void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+
+  /** Forget past points, e.g. when tracking was lost */
+  void reset();
+
+  /**
+   * @param point           gaze point, typically filtered
+   * @param timestamp_us    acquisition time of the frame of `point`
+   * @param movement        the SDK's classification of the eye movement
+   * @param target_us       when the point is expected to be seen
+   * @return the point predicted at target_us, or `point` if disabled
+   */
+  cv::Point2f predict(cv::Point2f point, std::int64_t timestamp_us, EyedidEyeMovementState movement,
+                      std::int64_t target_us);
+
+  /** May be called from any thread */
+  Stats stats() const;
+
+ private:
+  struct Pending {
+    std::int64_t target_us = 0;
+    std::int64_t horizon_us = 0;
+    cv::Point2f predicted;
+    cv::Point2f held;
+  };
+
+  static constexpr int kPending = 32;
+
+  void check(cv::Point2f point, std::int64_t timestamp_us);
+
+  std::atomic_bool enabled_{true};
+
+  bool started_ = false;
+  cv::Point2f last_point_;
+  std::int64_t last_us_ = 0;
+  cv::Point2f velocity_;
+
+  // Predictions waiting for a point at or after their target time, oldest first
+  Pending pending_[kPending];
+  int pending_head_ = 0;
+  int pending_count_ = 0;
+
+  // Written on the tracking thread; errors in 1/100 px
+  std::atomic<std::uint64_t> checked_{0};
+  std::atomic<std::int64_t> horizon_sum_us_{0};
+  std::atomic<std::int64_t> error_sum_{0};
+  std::atomic<std::int64_t> hold_error_sum_{0};
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_GAZE_PREDICTOR_H_
@@ -0,0 +1,129 @@
+/**
+ * Move-only callable wrapper that stores the callable inside itself.
+ *
+ * Unlike std::function, a callable never goes to the heap: one that does not fit
+ * `Capacity` bytes is a compile error. Calls go through one function pointer kept
+ * in the object itself. Calling an empty inplace_function throws std::bad_function_call,
+ * like std::function; the empty state has a call pointer of its own, so calls do not branch.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_INPLACE_FUNCTION_H_
+#define EYEDID_CPP_SAMPLE_INPLACE_FUNCTION_H_
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace sample {
+
+template<typename Signature, std::size_t Capacity = 48>
+class inplace_function;
+
+template<typename R, typename ...Args, std::size_t Capacity>
+class inplace_function<R(Args...), Capacity> {
+ public:
+  inplace_function() = default;
+
+  template<typename F, typename = typename std::enable_if<
+    !std::is_same<typename std::decay<F>::type, inplace_function>::value>::type>
+  inplace_function(F&& func) {  // NOLINT: implicit like std::function
+    using T = typename std::decay<F>::type;
+    static_assert(sizeof(T) <= Capacity, "callable does not fit in inplace_function; capture less or raise Capacity");
+    static_assert(alignof(T) <= alignof(storage_type), "callable is over-aligned for inplace_function");
+    ::new (static_cast<void*>(&storage_)) T(std::forward<F>(func));
+    invoke_ = &ops_for<T>::invoke;
+    ops_ = &ops_for<T>::table;
+  }
+
+  inplace_function(inplace_function&& other) noexcept {
+    if (other.ops_) {
+      other.ops_->move(&storage_, &other.storage_);
+      invoke_ = other.invoke_;
+      ops_ = other.ops_;
+      other.reset();
+    }
+  }
+
+  inplace_function& operator=(inplace_function&& other) noexcept {
+    if (this != &other) {
+      reset();
+      if (other.ops_) {
+        other.ops_->move(&storage_, &other.storage_);
+        invoke_ = other.invoke_;
+        ops_ = other.ops_;
+        other.reset();
+      }
+    }
+    return *this;
+  }
+
+  inplace_function(const inplace_function&) = delete;
+  inplace_function& operator=(const inplace_function&) = delete;
+
+  ~inplace_function() { reset(); }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  /** @throws std::bad_function_call if empty */
+  R operator()(Args... args) const {
+    return invoke_(&storage_, std::forward<Args>(args)...);
+  }
+
+ private:
+  using storage_type = typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type;
+
+  using invoke_type = R (*)(void* func, Args&&... args);
+
+  /** Everything but the call, which is not on the hot path */
+  struct ops {
+    /** Move-construct into `dst` */
+    void (*move)(void* dst, void* src);
+    void (*destroy)(void* func);
+  };
+
+  static R invoke_empty(void*, Args&&...) {
+    throw std::bad_function_call();
+  }
+
+  template<typename T>
+  struct ops_for {
+    static R invoke(void* func, Args&&... args) {
+      return (*static_cast<T*>(func))(std::forward<Args>(args)...);
+    }
+    static void move(void* dst, void* src) {
+      ::new (dst) T(std::move(*static_cast<T*>(src)));
+    }
+    static void destroy(void* func) {
+      static_cast<T*>(func)->~T();
+    }
+    static const ops table;
+  };
+
+  void reset() {
+    if (ops_) {
+      ops_->destroy(&storage_);
+      invoke_ = &invoke_empty;
+      ops_ = nullptr;
+    }
+  }
+
+  // The call pointer first, so that a call touches the first cache line of small callables
+  invoke_type invoke_ = &invoke_empty;
+  const ops* ops_ = nullptr;
+  // Callables are invoked as non-const, like std::function does
+  mutable storage_type storage_;
+};
+
+template<typename R, typename ...Args, std::size_t Capacity>
+template<typename T>
+const typename inplace_function<R(Args...), Capacity>::ops
+inplace_function<R(Args...), Capacity>::ops_for<T>::table = {
+  &inplace_function<R(Args...), Capacity>::ops_for<T>::move,
+  &inplace_function<R(Args...), Capacity>::ops_for<T>::destroy,
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_INPLACE_FUNCTION_H_
@@ -0,0 +1,58 @@
+/**
+ * Lock-free latency accumulator.
+ * add() may be called from one thread while any thread reads a snapshot().
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_LATENCY_STATS_H_
+#define EYEDID_CPP_SAMPLE_LATENCY_STATS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+namespace sample {
+
+class LatencyStats {
+ public:
+  struct Snapshot {
+    std::uint64_t count = 0;
+    std::int64_t last_us = 0;
+    std::int64_t min_us = 0;
+    std::int64_t max_us = 0;
+    double mean_us = 0;
+  };
+
+  void add(std::int64_t us) {
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(us, std::memory_order_relaxed);
+    last_.store(us, std::memory_order_relaxed);
+
+    auto cur = min_.load(std::memory_order_relaxed);
+    while (us < cur && !min_.compare_exchange_weak(cur, us, std::memory_order_relaxed)) {}
+    cur = max_.load(std::memory_order_relaxed);
+    while (us > cur && !max_.compare_exchange_weak(cur, us, std::memory_order_relaxed)) {}
+  }
+
+  Snapshot snapshot() const {
+    Snapshot s;
+    s.count = count_.load(std::memory_order_relaxed);
+    if (s.count == 0)
+      return s;
+    s.last_us = last_.load(std::memory_order_relaxed);
+    s.min_us = min_.load(std::memory_order_relaxed);
+    s.max_us = max_.load(std::memory_order_relaxed);
+    s.mean_us = static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(s.count);
+    return s;
+  }
+
+ private:
+  std::atomic<std::uint64_t> count_{0};
+  std::atomic<std::int64_t> sum_{0};
+  std::atomic<std::int64_t> last_{0};
+  std::atomic<std::int64_t> min_{std::numeric_limits<std::int64_t>::max()};
+  std::atomic<std::int64_t> max_{std::numeric_limits<std::int64_t>::min()};
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_LATENCY_STATS_H_
@@ -1,7 +1,12 @@
+#include <algorithm>
+#include <atomic>
+#include <csignal>
 #include <iostream>
 #include <thread>
 #include <stdexcept>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <opencv2/opencv.hpp>
 
@@ -10,7 +15,19 @@
 
 #include "tracker_manager.h"
 #include "view.h"
-#include "camera_thread.h"
+#include "capture_manager.h"
+#include "color_convert.h"
+#include "event_loop.h"
+#include "frame_consumer.h"
+#include "options.h"
+#include "replay_source.h"
+#include "startup_tasks.h"
+#include "timestamp.h"
+#include "video_recorder.h"
+#include "window_geometry.h"
+#ifdef __linux__
+#  include "v4l2_source.h"
+#endif
 
 #ifdef EYEDID_TEST_KEY
 #  define EYEDID_STRINGFY_IMPL(x) #x
@@ -24,142 +41,313 @@ const char* license_key = "dev_3eotrio3uzic15jf46dy6jntus6pfqqd49lp7vtd";
 // See [https://docs.eyedid.ai/](https://docs.eyedid.ai/) for more information
 
 void printDisplays(const std::vector<eyedid::DisplayInfo>& displays);
+void printFrameStats(const char* name, const sample::FrameConsumerStats& stats);
+void printLatency(const char* name, const sample::LatencyStats::Snapshot& latency);
+void printCameraStats(std::size_t index, const sample::CameraStats& stats);
+std::vector<std::unique_ptr<sample::FrameSource>> makeFrameSources(const sample::Options& options);
+eyedid::DisplayInfo makeVirtualDisplay();
 
-int main() {
-    // Initialize  Eyedid library
-    // This must be called before calling any other eyedid functions
-    try {
-        eyedid::global_init();
-    }
-    catch (const std::exception& e) {
-        std::cerr << e.what() << '\n';
-        return EXIT_FAILURE;
-    }
+// Set by Ctrl+C, the only way to stop a headless view that is not replaying
+static volatile std::sig_atomic_t interrupted = 0;
 
-    // Get display information
-    const auto displays = eyedid::getDisplayLists();
-    if (displays.empty()) {
-        std::cerr << "Cannot find displays\n";
-        return EXIT_FAILURE;
-    }
-    printDisplays(displays);
+int main(int argc, char** argv) {
+    const auto launch_us = sample::steadyMicros();
 
-    // Create gaze-tracker manager
-    auto tracker_manager = std::make_shared<sample::TrackerManager>();
-    auto tracker_manager_ptr = tracker_manager.get();
+    sample::Options sample_options;
+    if (!sample::parseOptions(argc, argv, &sample_options))
+        return EXIT_FAILURE;
 
     // Set additional feature(user status) options
     EyedidTrackerOptions options;
     options.use_blink = kEyedidTrue;
     options.use_user_status = kEyedidTrue;
 
-    // Authenticate and initialize GazeTracker
-    auto code = tracker_manager->initialize(license_key, options);
-    if (!code)
+    // Frames only matter while they are new, so stale frames are dropped instead of queued.
+    // An unthrottled replay is a throughput benchmark instead: every frame is processed and the
+    // slowest listener sets the pace.
+    const auto frame_policy = sample_options.replay_unthrottled ? sample::FramePolicy::kBlock : sample::FramePolicy::kLatestOnly;
+
+    // Create a gaze-tracker manager and a capture thread for each camera.
+    // Each camera is captured and tracked independently, on its own core if pinning is enabled.
+    auto frame_sources = makeFrameSources(sample_options);
+    if (frame_sources.empty())
         return EXIT_FAILURE;
 
+    // Listeners that print run here, so a slow terminal never stalls the tracker or a camera.
+    // Declared first, so that it outlives the signals connected to it.
+    sample::event_loop console;
+    console.start();
 
-    // Change default coordinate system from camera-millimeters to display-pixels
-    // This assumes that the camera is located at the top-center of the main display
-    const auto& main_display = displays[0];
-    tracker_manager->setDefaultCameraToDisplayConverter(main_display);
+    const char* window_name = "eyedid-sample";
+    // Trackers map gaze points into the window through this cache, refreshed by the render loop.
+    // Declared before the capture manager, so that it outlives the trackers on every return path.
+    sample::WindowGeometry window_geometry(window_name);
 
-    // Set the whole monitor region as a ROI that determines user attention.
-    if (options.use_user_status) {
-        tracker_manager->setWholeScreenToAttentionRegion(main_display);
+    sample::CaptureManager capture_manager(license_key, options, frame_policy);
+    const auto cores = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i = 0; i < frame_sources.size(); ++i) {
+        const int cpu = sample_options.pin_threads ? static_cast<int>(i % cores) : -1;
+        capture_manager.addCamera(std::move(frame_sources[i]), cpu);
     }
 
+    // The first camera drives the view and the calibration
+    auto& tracker_manager = capture_manager.tracker(0);
 
-    // Create and run OpenCV camera in concurrent thread
-    int camera_index = 0;
-    sample::CameraThread camera_thread;
-    if (!camera_thread.run(camera_index))
-        return EXIT_FAILURE;
+
+    /// Start up
+    // License authentication and camera warm-up are slow and independent, so every step runs
+    // as soon as the steps it needs are done. Where the time went is printed afterwards.
+    sample::StartupTasks startup;
+    std::vector<eyedid::DisplayInfo> displays;
+    std::shared_ptr<sample::View> view;
+
+    // Initialize  Eyedid library
+    // This must be called before calling any other eyedid functions
+    const auto sdk_task = startup.add("sdk", []() {
+        eyedid::global_init();
+        return true;
+        });
+
+    // Get display information
+    const auto display_task = startup.add("displays", [&]() {
+        displays = eyedid::getDisplayLists();
+        if (displays.empty() && sample_options.headless)
+            displays.push_back(makeVirtualDisplay());
+        if (displays.empty()) {
+            std::cerr << "Cannot find displays\n";
+            return false;
+        }
+        printDisplays(displays);
+        std::cout << "Color conversion: " << sample::colorConvertIsa() << '\n';
+        return true;
+        }, { sdk_task });
 
     // Create a view for drawing GUI - üȭ
-    const char* window_name = "eyedid-sample";
-    auto view = std::make_shared<sample::View>(main_display.widthPx, main_display.heightPx, window_name);
+    // The window is created on the main thread, as GUI toolkits require.
+    startup.add("view", [&]() {
+        const auto& main_display = displays[0];
+        view = std::make_shared<sample::View>(main_display.widthPx, main_display.heightPx, window_name,
+            sample_options.render_scale, sample_options.headless);
+        view->scheduler().setMaxFps(sample_options.max_fps);
+
+        // A headless view covers the whole display
+        if (sample_options.headless) {
+            eyedid::Rect whole_display;
+            whole_display.width = main_display.widthPx;
+            whole_display.height = main_display.heightPx;
+            window_geometry.setFixed(whole_display);
+        }
+        else {
+            window_geometry.refresh();
+        }
+        return true;
+        }, { display_task }, sample::StartupTasks::Affinity::kMain);
+
+    for (std::size_t i = 0; i < capture_manager.size(); ++i) {
+        const auto camera_name = std::to_string(i);
+
+        // Authenticate and initialize GazeTracker
+        const auto auth_task = startup.add("auth " + camera_name, [&, i]() {
+            return capture_manager.initialize(i);
+            }, { sdk_task });
+
+        startup.add("tracker " + camera_name, [&, i]() {
+            auto& tracker = capture_manager.tracker(i);
+            const auto& main_display = displays[0];
+            tracker.setTrackingFps(sample_options.tracking_fps);
+            tracker.setGazeFilter(sample_options.gaze_filter);
+            tracker.setGazePrediction(sample_options.gaze_prediction);
+            tracker.window_name_ = window_name;
+            tracker.setWindowGeometry(&window_geometry);
+
+            // Change default coordinate system from camera-millimeters to display-pixels
+            // This assumes that the camera is located at the top-center of the main display.
+            // Use setCameraToDisplayConverter for cameras mounted elsewhere.
+            tracker.setDefaultCameraToDisplayConverter(main_display);
+
+            // Set the whole monitor region as a ROI that determines user attention.
+            if (options.use_user_status) {
+                tracker.setWholeScreenToAttentionRegion(main_display);
+            }
+            return true;
+            }, { auth_task, display_task });
+
+        // Open the camera and wait for its first frame
+        startup.add("camera " + camera_name, [&, i]() {
+            return capture_manager.open(i);
+            });
+    }
+
+    const auto started = startup.run();
+    startup.printReport(std::cout);
+    if (!started)
+        return EXIT_FAILURE;
     auto view_ptr = view.get();
-    tracker_manager->window_name_ = window_name;
 
 
     /// Adding listeners to events
 
     // Show gaze point according to the value. Red means the Eyedid cannot inference the gaze point
-    tracker_manager->on_gaze_.connect([=](int x, int y, bool valid) {
-        sample::write_lock_guard lock(view_ptr->write_mutex());
-        if (valid) {
-            view_ptr->gaze_point_.center = { x, y };
-            view_ptr->gaze_point_.color = { 0, 220, 220 };
-        }
-        else {
-            view_ptr->gaze_point_.color = { 0, 0, 220 };
-        }
-        view_ptr->gaze_point_.visible = true;
+    tracker_manager.on_gaze_.connect([=](int x, int y, bool valid) {
+        view_ptr->setGaze(x, y, valid);
         }, view);
 
     // Change UI elements state while calibrating
-    tracker_manager->on_calib_start_.connect([=]() {
-        sample::write_lock_guard lock(view_ptr->write_mutex());
-        view_ptr->calibration_desc_.visible = true;
-        for (auto& desc : view_ptr->desc_)
-            desc.visible = false;
-        view_ptr->frame_.visible = false;
+    tracker_manager.on_calib_start_.connect([=]() {
+        view_ptr->startCalibration();
         }, view);
-    tracker_manager->on_calib_finish_.connect([=](const std::vector<float>& data) {
-        sample::write_lock_guard lock(view_ptr->write_mutex());
-        view_ptr->calibration_desc_.visible = false;
-        view_ptr->calibration_point_.visible = false;
-        for (auto& desc : view_ptr->desc_)
-            desc.visible = true;
-        view_ptr->frame_.visible = true;
+    tracker_manager.on_calib_finish_.connect([=](const std::vector<float>& data) {
+        view_ptr->finishCalibration();
         }, view);
-    tracker_manager->on_calib_next_point_.connect([=](int x, int y) {
-        sample::write_lock_guard lock(view_ptr->write_mutex());
-        view_ptr->calibration_point_.center = { x, y };
-        view_ptr->calibration_point_.visible = true;
-        view_ptr->calibration_desc_.visible = false;
-        }, view);
-    tracker_manager->on_calib_progress_.connect([=](float progress) {
-        std::cout << '\r' << progress * 100 << '%';
+    tracker_manager.on_calib_next_point_.connect([=](int x, int y) {
+        view_ptr->showCalibrationPoint(x, y);
         }, view);
+    // Only the newest progress is worth printing
+    tracker_manager.on_calib_progress_.connect([=](float progress) {
+        std::cout << '\r' << progress * 100 << '%' << std::flush;
+        }, view, console, sample::queue_policy::kLatestOnly);
 
 
-    /// Add camera frame listener
-    // 1. draw the preview to the view
-    camera_thread.on_frame_.connect([=](const cv::Mat& frame) {
-        sample::write_lock_guard lock(view_ptr->write_mutex());
+    /// Add camera frame listeners
+    // Each listener runs on its own FrameConsumer thread, so the capture thread only hands frames over.
+    // CaptureManager already passes every camera's frames to its own tracker.
+    // Draw the preview of the first camera to the view
+    // Scale once per camera frame, straight into the view's next preview buffer.
+    // The view then only copies the scaled frame until a new one arrives.
+    const auto preview_size = view->previewSize();
+    // Conversion buffer of this consumer; the lambda owns its copy, so pipelines never share one
+    cv::Mat bgr;
+    auto preview_consumer = std::make_shared<sample::FrameConsumer>([=](const sample::Frame& frame) mutable {
+        const cv::Mat* src = &frame.mat();
+        if (frame.info().format != sample::PixelFormat::kBGR) {
+            sample::toBGR(frame, &bgr);
+            src = &bgr;
+        }
         //  ȭ: 1280x720  ( )
-        cv::resize(frame, view_ptr->frame_.buffer, { 1280, 720 });
-        }, view);
+        cv::resize(*src, view_ptr->previewBuffer(), preview_size);
+        view_ptr->publishPreview();
+        }, frame_policy);
+    auto preview_consumer_ptr = preview_consumer.get();
+    // After the tracker's listener, which is in the realtime group
+    capture_manager.camera(0).on_frame_.connect(sample::slot_group::kBackground, [=](const sample::Frame& frame) {
+        preview_consumer_ptr->push(frame);
+        }, preview_consumer);
+    capture_manager.camera(0).on_frame_.measure_groups(true);
 
-    // 2. Pass the frame and the current timestamp in milliseconds to the Eyedid SDK
-    camera_thread.on_frame_.connect([=](const cv::Mat& frame) {
-        static auto cvt = new cv::Mat();
-        static const auto current_time = [] {
-            using clock = std::chrono::steady_clock;
-            return std::chrono::duration_cast<std::chrono::milliseconds>(clock::now().time_since_epoch()).count();
-            };
-        cv::cvtColor(frame, *cvt, cv::COLOR_BGR2RGB);
-        tracker_manager_ptr->addFrame(current_time(), *cvt);
-        }, tracker_manager);
+    auto finished_cameras = std::make_shared<std::atomic<std::size_t>>(0);
+    for (std::size_t i = 0; i < capture_manager.size(); ++i) {
+        capture_manager.camera(i).on_end_.connect([=]() {
+            finished_cameras->fetch_add(1);
+            });
+        capture_manager.camera(i).on_end_.connect([=]() {
+            std::cout << "Replay finished (camera " << i << ")\n";
+            }, console, sample::queue_policy::kDropOldest);
+    }
 
+    // Time to first gaze, the number startup is optimized for
+    auto first_gaze = std::make_shared<std::atomic_bool>(false);
+    tracker_manager.on_gaze_.connect([=](int x, int y, bool valid) {
+        if (!first_gaze->exchange(true))
+            std::cout << "First gaze result " << (sample::steadyMicros() - launch_us) / 1000.0 << "ms after launch\n";
+        });
 
+    for (std::size_t i = 0; i < capture_manager.size(); ++i)
+        capture_manager.start(i);
+
+
+    // Record what the view shows, encoded on a background thread
+    sample::VideoRecorder recorder;
+    if (!sample_options.record_path.empty()) {
+        const auto codec = sample_options.record_raw ? sample::VideoRecorder::Codec::kRaw : sample::VideoRecorder::Codec::kMJPEG;
+        if (!recorder.open(sample_options.record_path, sample_options.max_fps, view->renderSize(), codec))
+            return EXIT_FAILURE;
+        view->setRecorder(&recorder);
+    }
+
+    std::signal(SIGINT, [](int) { interrupted = 1; });
+
+    // The main thread sleeps until the gaze, the preview or the calibration state changes
+    const auto loop_start_us = sample::steadyMicros();
+    const auto loop_start_cpu_us = sample::threadCpuMicros();
     while (true) {
         // Draw a window.
-        int key = view->draw(10);
+        int key = view->update();
+        // The window may have been moved or resized
+        window_geometry.poll(sample::steadyMicros());
+        // Gaze points are predicted that far ahead of when they arrive
+        tracker_manager.setDisplayLatency(static_cast<std::int64_t>(view->gazeLatency().mean_us));
 
-        if (key == 27/* ESC */) {
+        if (key == 27/* ESC */ || interrupted) {
+            break;
+        }
+        else if (view->headless() && finished_cameras->load() == capture_manager.size()) {
+            // Nobody can press ESC, so stop once every replay is done
             break;
         }
         else if (key == 'c' || key == 'C') {
-            tracker_manager->startFullWindowCalibration(
+            tracker_manager.startFullWindowCalibration(
                 kEyedidCalibrationPointFive,
                 kEyedidCalibrationAccuracyHigh);
         }
+        else if (key == 'h' || key == 'H') {
+            view->heatmap().visible = !view->heatmap().visible;
+        }
+        else if (key == 'f' || key == 'F') {
+            // Keep the parameters given on the command line, switch the kind only
+            auto& filter = sample_options.gaze_filter;
+            filter.kind = static_cast<sample::GazeFilter::Kind>((static_cast<int>(filter.kind) + 1) % sample::GazeFilter::kKindCount);
+            for (std::size_t i = 0; i < capture_manager.size(); ++i)
+                capture_manager.tracker(i).setGazeFilter(filter);
+            std::cout << "Gaze filter: " << sample::gazeFilterName(filter.kind) << '\n';
+        }
     }
+    const auto loop_end_us = sample::steadyMicros();
+    const auto loop_end_cpu_us = sample::threadCpuMicros();
     view->closeWindow();
+    view->setRecorder(nullptr);
+    recorder.close();
 
+    // Stop capturing before the listeners and the view are destroyed
+    capture_manager.stop();
+    for (std::size_t i = 0; i < capture_manager.size(); ++i)
+        capture_manager.tracker(i).setWindowGeometry(nullptr);
+    preview_consumer->join();
+    // Print what the console has not yet, here rather than after the stats
+    console.stop();
+    console.run_pending();
+    printFrameStats("preview", preview_consumer->stats());
+    printLatency("frame-to-tracker listener", capture_manager.camera(0).on_frame_.group_latency(sample::slot_group::kRealtime));
+    printLatency("frame-to-preview listener", capture_manager.camera(0).on_frame_.group_latency(sample::slot_group::kBackground));
+    const auto view_stats = view->stats();
+    std::cout << "View draws: " << view_stats.draws
+        << ", window updates: " << view_stats.updates
+        << ", render: " << view_stats.mean_render_us / 1000.0 << "ms/draw"
+        << ", redrawn area: " << view_stats.mean_dirty_fraction * 100 << "%/update\n";
+    // The view draws on this thread, so its text went through this thread's cache
+    const auto text_stats = sample::drawables::TextSpriteCache::forThisThread().stats();
+    std::cout << "Text sprites: " << text_stats.hits << " hits, " << text_stats.misses << " rasterized, "
+        << text_stats.evictions << " evicted, " << text_stats.bytes / 1024 << "KB cached\n";
+    const auto schedule_stats = view->scheduler().stats();
+    const auto loop_us = loop_end_us - loop_start_us;
+    std::cout << "Render loop: " << schedule_stats.changes << " redraws, "
+        << schedule_stats.idle_ticks << " idle ticks, CPU "
+        << (loop_us > 0 ? 100.0 * static_cast<double>(loop_end_cpu_us - loop_start_cpu_us) / static_cast<double>(loop_us) : 0.0)
+        << "%\n";
+    const auto prediction = tracker_manager.prediction();
+    std::cout << "Gaze prediction" << (sample_options.gaze_prediction ? "" : " (disabled)") << ": "
+        << prediction.checked << " checked, horizon " << prediction.mean_horizon_us / 1000.0 << "ms"
+        << ", error " << prediction.mean_error_px << "px"
+        << " vs " << prediction.mean_hold_error_px << "px unpredicted\n";
+    printLatency("gaze-to-screen", view->gazeLatency());
+    const auto window_stats = window_geometry.stats();
+    std::cout << "Window geometry: " << window_stats.queries << " queries, " << window_stats.changes << " changes\n";
+    if (!sample_options.record_path.empty()) {
+        const auto record_stats = recorder.stats();
+        std::cout << "Recorded " << record_stats.written << " frames to " << sample_options.record_path
+            << " (" << record_stats.submitted << " updates, " << record_stats.dropped << " dropped)\n";
+    }
+    for (std::size_t i = 0; i < capture_manager.size(); ++i)
+        printCameraStats(i, capture_manager.stats(i));
 
     return EXIT_SUCCESS;
 }
@@ -176,3 +364,81 @@ void printDisplays(const std::vector<eyedid::DisplayInfo>& displays) {
             << "\n";
     }
 }
+
+void printFrameStats(const char* name, const sample::FrameConsumerStats& stats) {
+    std::cout << "Frames(" << name << ") received: " << stats.received
+        << ", processed: " << stats.processed
+        << ", dropped: " << stats.dropped << '\n';
+}
+
+void printLatency(const char* name, const sample::LatencyStats::Snapshot& latency) {
+    std::cout << "Latency(" << name << ") samples: " << latency.count
+        << ", mean: " << latency.mean_us / 1000.0 << "ms"
+        << ", min: " << latency.min_us / 1000.0 << "ms"
+        << ", max: " << latency.max_us / 1000.0 << "ms\n";
+}
+
+void printCameraStats(std::size_t index, const sample::CameraStats& stats) {
+    std::cout << "Camera " << index << " captured: " << stats.captured
+        << " (" << stats.capture_fps << " fps)"
+        << ", starved: " << stats.starved
+        << ", gaze: " << stats.latency.count
+        << " (" << stats.gaze_fps << " fps)\n";
+    printFrameStats("tracker", stats.tracker);
+    std::cout << "Admission admitted: " << stats.admission.admitted
+        << ", skipped: " << stats.admission.skipped
+        << ", rejected: " << stats.admission.rejected
+        << ", dropped: " << stats.admission.dropped << '\n';
+    printLatency("capture-to-gaze", stats.latency);
+}
+
+std::vector<std::unique_ptr<sample::FrameSource>> makeFrameSources(const sample::Options& options) {
+    std::vector<std::unique_ptr<sample::FrameSource>> sources;
+    switch (options.capture) {
+    case sample::CaptureBackend::kOpenCV:
+        for (const auto camera_index : options.camera_indices)
+            sources.emplace_back(new sample::OpenCVSource(camera_index));
+        break;
+    case sample::CaptureBackend::kV4L2:
+#ifdef __linux__
+        for (const auto& device : options.devices) {
+            sample::V4L2Options v4l2;
+            v4l2.device = device;
+            v4l2.format = options.pixel_format;
+            v4l2.width = options.width;
+            v4l2.height = options.height;
+            v4l2.fps = options.fps;
+            v4l2.buffer_count = static_cast<std::size_t>(options.buffer_count);
+            sources.emplace_back(new sample::V4L2Source(v4l2));
+        }
+#else
+        std::cerr << "V4L2 capture is only available on Linux\n";
+#endif
+        break;
+    case sample::CaptureBackend::kReplay:
+        for (const auto& path : options.replay_paths) {
+            sample::ReplayOptions replay;
+            replay.path = path;
+            replay.pacing = options.replay_unthrottled ? sample::ReplayPacing::kUnthrottled : sample::ReplayPacing::kRealTime;
+            replay.fps = options.replay_fps;
+            replay.loop = options.replay_loop;
+            replay.raw_format = options.pixel_format;
+            replay.width = options.width;
+            replay.height = options.height;
+            sources.emplace_back(new sample::ReplaySource(replay));
+        }
+        break;
+    }
+    return sources;
+}
+
+eyedid::DisplayInfo makeVirtualDisplay() {
+    // A 24 inch 1080p monitor, the canvas of a headless view on machines without a display
+    eyedid::DisplayInfo display{};
+    display.displayName = "virtual";
+    display.widthPx = 1920;
+    display.heightPx = 1080;
+    display.widthMm = 531;
+    display.heightMm = 299;
+    return display;
+}
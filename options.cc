@@ -0,0 +1,218 @@
+#include "options.h"
+
+#include <cstdlib>
+#include <iostream>
+
+namespace sample {
+
+static void printUsage(const char* program) {
+  std::cout << "Usage: " << program << " [options]\n"
+    << "  --capture=opencv|v4l2    capture backend (default: opencv)\n"
+    << "  --camera=N[,N...]        OpenCV camera indices (default: 0)\n"
+    << "  --device=PATH[,PATH...]  V4L2 devices (default: /dev/video0)\n"
+    << "  --format=yuyv|nv12|mjpeg|bgr\n"
+    << "                           V4L2 pixel format (default: yuyv)\n"
+    << "  --width=N --height=N     V4L2 frame size (default: 1280x720)\n"
+    << "  --fps=N                  V4L2 frame rate, 0 for driver default (default: 30)\n"
+    << "  --buffers=N              V4L2 driver buffer count (default: 4)\n"
+    << "  --replay=PATH[,PATH...]  replay a video file, an image glob (e.g. 'dir/*.png') or raw frames\n"
+    << "                           (.raw, geometry from --format/--width/--height) instead of a camera\n"
+    << "  --replay-pacing=realtime|unthrottled\n"
+    << "                           replay at recorded speed or as fast as the pipeline accepts (default: realtime)\n"
+    << "  --replay-fps=N           frame rate of image and raw sequences (default: 30)\n"
+    << "  --replay-loop=0|1        start over at the end (default: 0)\n"
+    << "  --tracking-fps=N         gaze tracking rate limit (default: 30)\n"
+    << "  --gaze-filter=none|mean[:N]|one-euro[:MIN_CUTOFF,BETA]|kalman[:ACCELERATION,NOISE]\n"
+    << "                           gaze point smoothing (default: mean:3, one-euro:1,0.007, kalman:4000,10)\n"
+    << "  --gaze-prediction=0|1    extrapolate gaze points to the time they are shown (default: 1)\n"
+    << "  --render-scale=S         draw the view at S times the display resolution, 0 < S <= 1 (default: 1)\n"
+    << "  --max-fps=N              redraw the view at most N times per second (default: 60)\n"
+    << "  --headless=0|1           compose the view offscreen, without a window (default: 0)\n"
+    << "  --record=PATH            record the view to an AVI file\n"
+    << "  --record-codec=mjpeg|raw compression of --record (default: mjpeg)\n"
+    << "  --pin=0|1                pin each capture thread to its own core (default: 1)\n"
+    << "Inputs given as a list are captured concurrently, each with its own tracker.\n";
+}
+
+static bool parseInt(const std::string& value, int* out) {
+  char* end = nullptr;
+  const long v = std::strtol(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0')
+    return false;
+  *out = static_cast<int>(v);
+  return true;
+}
+
+static bool parseDouble(const std::string& value, double* out) {
+  char* end = nullptr;
+  const double v = std::strtod(value.c_str(), &end);
+  if (value.empty() || *end != '\0')
+    return false;
+  *out = v;
+  return true;
+}
+
+static bool parseBool(const std::string& value, bool* out) {
+  if (value == "1" || value == "true") *out = true;
+  else if (value == "0" || value == "false") *out = false;
+  else return false;
+  return true;
+}
+
+static std::vector<std::string> splitList(const std::string& value) {
+  std::vector<std::string> items;
+  std::size_t begin = 0;
+  while (true) {
+    const auto end = value.find(',', begin);
+    items.push_back(value.substr(begin, end - begin));
+    if (end == std::string::npos)
+      break;
+    begin = end + 1;
+  }
+  return items;
+}
+
+static bool parseIntList(const std::string& value, std::vector<int>* out) {
+  std::vector<int> list;
+  for (const auto& item : splitList(value)) {
+    int v;
+    if (!parseInt(item, &v))
+      return false;
+    list.push_back(v);
+  }
+  *out = list;
+  return true;
+}
+
+bool parseGazeFilter(const std::string& value, GazeFilter::Params* out) {
+  const auto colon = value.find(':');
+  const auto name = value.substr(0, colon);
+  std::vector<double> params;
+  if (colon != std::string::npos) {
+    for (const auto& item : splitList(value.substr(colon + 1))) {
+      double v;
+      if (!parseDouble(item, &v) || v < 0)
+        return false;
+      params.push_back(v);
+    }
+  }
+
+  GazeFilter::Params filter;
+  if (name == "none") {
+    filter.kind = GazeFilter::Kind::kNone;
+    if (!params.empty())
+      return false;
+  }
+  else if (name == "mean") {
+    filter.kind = GazeFilter::Kind::kMean;
+    if (params.size() > 1)
+      return false;
+    if (!params.empty())
+      filter.window = static_cast<int>(params[0]);
+    if (filter.window < 1 || filter.window > GazeFilter::kMaxWindow)
+      return false;
+  }
+  else if (name == "one-euro") {
+    filter.kind = GazeFilter::Kind::kOneEuro;
+    if (params.size() > 2)
+      return false;
+    if (params.size() > 0) filter.min_cutoff = static_cast<float>(params[0]);
+    if (params.size() > 1) filter.beta = static_cast<float>(params[1]);
+    if (filter.min_cutoff <= 0)
+      return false;
+  }
+  else if (name == "kalman") {
+    filter.kind = GazeFilter::Kind::kKalman;
+    if (params.size() > 2)
+      return false;
+    if (params.size() > 0) filter.acceleration_noise = static_cast<float>(params[0]);
+    if (params.size() > 1) filter.measurement_noise = static_cast<float>(params[1]);
+    if (filter.measurement_noise <= 0)
+      return false;
+  }
+  else {
+    return false;
+  }
+  *out = filter;
+  return true;
+}
+
+static bool parseOption(const std::string& name, const std::string& value, Options* options) {
+  if (name == "capture") {
+    if (value == "opencv") options->capture = CaptureBackend::kOpenCV;
+    else if (value == "v4l2") options->capture = CaptureBackend::kV4L2;
+    else return false;
+    return true;
+  }
+  if (name == "format") {
+    if (value == "bgr") options->pixel_format = PixelFormat::kBGR;
+    else if (value == "yuyv") options->pixel_format = PixelFormat::kYUYV;
+    else if (value == "nv12") options->pixel_format = PixelFormat::kNV12;
+    else if (value == "mjpeg") options->pixel_format = PixelFormat::kMJPEG;
+    else return false;
+    return true;
+  }
+  if (name == "device") {
+    options->devices = splitList(value);
+    return true;
+  }
+  if (name == "replay") {
+    options->capture = CaptureBackend::kReplay;
+    options->replay_paths = splitList(value);
+    return true;
+  }
+  if (name == "replay-pacing") {
+    if (value == "realtime") options->replay_unthrottled = false;
+    else if (value == "unthrottled") options->replay_unthrottled = true;
+    else return false;
+    return true;
+  }
+  if (name == "record") {
+    options->record_path = value;
+    return !value.empty();
+  }
+  if (name == "record-codec") {
+    if (value == "mjpeg") options->record_raw = false;
+    else if (value == "raw") options->record_raw = true;
+    else return false;
+    return true;
+  }
+  if (name == "camera") return parseIntList(value, &options->camera_indices);
+  if (name == "width") return parseInt(value, &options->width);
+  if (name == "height") return parseInt(value, &options->height);
+  if (name == "fps") return parseInt(value, &options->fps);
+  if (name == "buffers") return parseInt(value, &options->buffer_count);
+  if (name == "replay-fps") return parseDouble(value, &options->replay_fps) && options->replay_fps > 0;
+  if (name == "replay-loop") return parseBool(value, &options->replay_loop);
+  if (name == "tracking-fps") return parseInt(value, &options->tracking_fps) && options->tracking_fps > 0;
+  if (name == "render-scale")
+    return parseDouble(value, &options->render_scale) && options->render_scale > 0 && options->render_scale <= 1;
+  if (name == "gaze-filter") return parseGazeFilter(value, &options->gaze_filter);
+  if (name == "gaze-prediction") return parseBool(value, &options->gaze_prediction);
+  if (name == "max-fps") return parseInt(value, &options->max_fps) && options->max_fps > 0;
+  if (name == "headless") return parseBool(value, &options->headless);
+  if (name == "pin") return parseBool(value, &options->pin_threads);
+  return false;
+}
+
+bool parseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const auto eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) {
+      printUsage(argv[0]);
+      return false;
+    }
+
+    const auto name = arg.substr(2, eq - 2);
+    const auto value = arg.substr(eq + 1);
+    if (!parseOption(name, value, options)) {
+      std::cerr << "Invalid option: " << arg << '\n';
+      printUsage(argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace sample
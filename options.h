@@ -0,0 +1,84 @@
+/**
+ * Command line options of the sample.
+ *
+ * Every option is written as `--name=value`. Run with `--help` to list them.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_OPTIONS_H_
+#define EYEDID_CPP_SAMPLE_OPTIONS_H_
+
+#include <string>
+#include <vector>
+
+#include "frame_pool.h"
+#include "gaze_filter.h"
+
+namespace sample {
+
+enum class CaptureBackend {
+  kOpenCV,
+  kV4L2,
+  kReplay,
+};
+
+/**
+ * Options that name an input take a comma-separated list, one entry per camera.
+ */
+struct Options {
+  CaptureBackend capture = CaptureBackend::kOpenCV;
+
+  /** cv::VideoCapture camera indices */
+  std::vector<int> camera_indices{0};
+
+  /** V4L2 backend. pixel_format, width and height also describe raw replay frames */
+  std::vector<std::string> devices{"/dev/video0"};
+  PixelFormat pixel_format = PixelFormat::kYUYV;
+  int width = 1280;
+  int height = 720;
+  int fps = 30;
+  int buffer_count = 4;
+
+  /** Replay backend, selected by --replay=PATH */
+  std::vector<std::string> replay_paths;
+  bool replay_unthrottled = false;
+  bool replay_loop = false;
+  double replay_fps = 30;
+
+  /** GazeTracker::setTrackingFps. Frames beyond it are skipped before color conversion */
+  int tracking_fps = 30;
+
+  /** Smoothing of gaze points, selected by --gaze-filter=NAME[:PARAMS] */
+  GazeFilter::Params gaze_filter;
+
+  /** Extrapolate gaze points to the time they are shown */
+  bool gaze_prediction = true;
+
+  /** Size of the view's back buffer relative to the display, in (0, 1] */
+  double render_scale = 1;
+
+  /** Most redraws per second. The view only redraws when gaze, preview or calibration changed */
+  int max_fps = 60;
+
+  /** Compose the view offscreen, without a window. For machines without a display */
+  bool headless = false;
+
+  /** Record the composed view to this AVI file if not empty */
+  std::string record_path;
+  bool record_raw = false;
+
+  /** Pin each capture thread to its own core */
+  bool pin_threads = true;
+};
+
+/**
+ * Parse argv into `options`.
+ * Prints the usage and returns false on `--help` or on an invalid option.
+ */
+bool parseOptions(int argc, char** argv, Options* options);
+
+/** Parse a --gaze-filter value, NAME[:PARAMS]. False if it is invalid */
+bool parseGazeFilter(const std::string& value, GazeFilter::Params* out);
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_OPTIONS_H_
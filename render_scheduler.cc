@@ -0,0 +1,76 @@
+#include "render_scheduler.h"
+
+#include <thread>
+
+#if defined(_WIN32)
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <time.h>
+#endif
+
+namespace sample {
+
+RenderScheduler::RenderScheduler(int max_fps, int idle_ms) : idle_(idle_ms) {
+  setMaxFps(max_fps);
+}
+
+void RenderScheduler::setMaxFps(int max_fps) {
+  min_interval_us_.store(max_fps > 0 ? 1000000 / max_fps : 0, std::memory_order_relaxed);
+}
+
+void RenderScheduler::notify() {
+  pending_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lck(mutex_);
+    cv_.notify_one();
+  }
+}
+
+bool RenderScheduler::wait() {
+  // Changes that arrive while sleeping here are picked up by the next draw, so the cap
+  // merges bursts of gaze points and frames into one redraw
+  const std::chrono::microseconds min_interval(min_interval_us_.load(std::memory_order_relaxed));
+  std::this_thread::sleep_until(last_wake_ + min_interval);
+
+  if (!pending_.load(std::memory_order_relaxed)) {
+    std::unique_lock<std::mutex> lck(mutex_);
+    sleeping_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    cv_.wait_for(lck, idle_, [this]() { return pending_.load(std::memory_order_relaxed); });
+    sleeping_.store(false, std::memory_order_relaxed);
+  }
+
+  last_wake_ = clock::now();
+  const auto changed = pending_.exchange(false, std::memory_order_acquire);
+  if (changed)
+    ++stats_.changes;
+  else
+    ++stats_.idle_ticks;
+  return changed;
+}
+
+std::int64_t threadCpuMicros() {
+#if defined(_WIN32)
+  FILETIME creation, exit, kernel, user;
+  if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+    return 0;
+  const auto ticks = [](const FILETIME& t) {
+    return (static_cast<std::int64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+  };
+  // 100 ns units
+  return (ticks(kernel) + ticks(user)) / 10;
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+  timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+    return 0;
+  return static_cast<std::int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#else
+  return 0;
+#endif
+}
+
+} // namespace sample
@@ -0,0 +1,76 @@
+/**
+ * Paces the render loop by data changes instead of a fixed polling interval.
+ *
+ * Producers call notify() whenever something visible changed. The render loop calls
+ * wait(), which returns as soon as there is a change, but never more often than the
+ * refresh cap, and otherwise after an idle tick so that keys are still polled.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_RENDER_SCHEDULER_H_
+#define EYEDID_CPP_SAMPLE_RENDER_SCHEDULER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace sample {
+
+class RenderScheduler {
+ public:
+  struct Stats {
+    /** wait() calls that returned because of a change */
+    std::uint64_t changes = 0;
+    /** wait() calls that returned on the idle tick */
+    std::uint64_t idle_ticks = 0;
+  };
+
+  /**
+   * @param max_fps  most wake-ups per second
+   * @param idle_ms  longest wait without a change
+   */
+  explicit RenderScheduler(int max_fps = 60, int idle_ms = 50);
+
+  RenderScheduler(const RenderScheduler&) = delete;
+  RenderScheduler& operator=(const RenderScheduler&) = delete;
+
+  void setMaxFps(int max_fps);
+
+  /**
+   * Something visible changed. May be called from any thread.
+   * Only takes a lock when the render loop is asleep, never while it draws.
+   */
+  void notify();
+
+  /**
+   * Sleep until notify() or the idle tick, and at least until 1 / max_fps after the previous wake-up.
+   * Call from the render loop only.
+   * @return true if something changed
+   */
+  bool wait();
+
+  /** Call from the render loop */
+  Stats stats() const { return stats_; }
+
+ private:
+  using clock = std::chrono::steady_clock;
+
+  std::atomic<std::int64_t> min_interval_us_{0};
+  std::chrono::milliseconds idle_;
+  clock::time_point last_wake_;
+
+  std::atomic_bool pending_{true};
+  std::atomic_bool sleeping_{false};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+
+  Stats stats_;
+};
+
+/** CPU time spent by the calling thread, in microseconds. 0 if not supported */
+std::int64_t threadCpuMicros();
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_RENDER_SCHEDULER_H_
@@ -0,0 +1,227 @@
+#include "replay_source.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+#include "timestamp.h"
+
+namespace sample {
+
+static bool endsWith(const std::string& str, const std::string& suffix) {
+  return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+ReplaySource::ReplaySource(ReplayOptions options)
+  : options_(std::move(options)), pool_(options_.pool_size) {}
+
+ReplaySource::~ReplaySource() {
+  close();
+}
+
+bool ReplaySource::open() {
+  close();
+
+  const auto& path = options_.path;
+  const bool raw = endsWith(path, ".raw");
+  if (path.find('*') != std::string::npos) {
+    cv::glob(path, files_);
+    std::sort(files_.begin(), files_.end());
+    if (files_.empty()) {
+      std::cerr << "Replay: no file matches " << path << '\n';
+      return false;
+    }
+    kind_ = raw ? Kind::kRawFiles : Kind::kImages;
+  } else if (raw) {
+    raw_stream_.open(path, std::ios::binary);
+    if (!raw_stream_) {
+      std::cerr << "Replay: failed to open " << path << '\n';
+      return false;
+    }
+    kind_ = Kind::kRawStream;
+  } else {
+    if (!video_.open(path)) {
+      std::cerr << "Replay: failed to open " << path << '\n';
+      return false;
+    }
+    kind_ = Kind::kVideo;
+  }
+
+  if (kind_ == Kind::kRawStream || kind_ == Kind::kRawFiles) {
+    format_ = options_.raw_format;
+    switch (format_) {
+      case PixelFormat::kBGR:
+        raw_rows_ = options_.height;
+        raw_type_ = CV_8UC3;
+        break;
+      case PixelFormat::kYUYV:
+        raw_rows_ = options_.height;
+        raw_type_ = CV_8UC2;
+        break;
+      case PixelFormat::kNV12:
+        raw_rows_ = options_.height * 3 / 2;
+        raw_type_ = CV_8UC1;
+        break;
+      default:
+        std::cerr << "Replay: raw frames must be bgr, yuyv or nv12\n";
+        return false;
+    }
+  } else {
+    format_ = PixelFormat::kBGR;
+  }
+
+  // Read the first frame to check the input and to size the pool
+  cv::Mat probe;
+  double media_ms;
+  if (!load(&probe, &media_ms) || probe.empty()) {
+    std::cerr << "Replay: failed to read a frame from " << path << '\n';
+    return false;
+  }
+  pool_.reserve(probe.rows, probe.cols, probe.type());
+  return rewind();
+}
+
+void ReplaySource::close() {
+  video_.release();
+  raw_stream_.close();
+  files_.clear();
+}
+
+bool ReplaySource::rewind() {
+  index_ = 0;
+  last_media_ms_ = -1;
+  has_base_ = false;
+  finished_ = false;
+
+  switch (kind_) {
+    case Kind::kVideo:
+      return video_.set(cv::CAP_PROP_POS_FRAMES, 0) || video_.open(options_.path);
+    case Kind::kRawStream:
+      raw_stream_.clear();
+      raw_stream_.seekg(0);
+      return static_cast<bool>(raw_stream_);
+    default:
+      return true;
+  }
+}
+
+bool ReplaySource::loadRaw(std::istream& in, cv::Mat* dst) {
+  dst->create(raw_rows_, options_.width, raw_type_);
+  const auto bytes = static_cast<std::streamsize>(dst->total() * dst->elemSize());
+  in.read(reinterpret_cast<char*>(dst->data), bytes);
+  return in.gcount() == bytes;
+}
+
+bool ReplaySource::load(cv::Mat* dst, double* media_ms) {
+  const double frame_ms = 1000.0 / options_.fps;
+  *media_ms = static_cast<double>(index_) * frame_ms;
+
+  switch (kind_) {
+    case Kind::kVideo: {
+      if (!video_.read(*dst))
+        return false;
+      // Fall back to the nominal frame rate if the container has no usable timestamps
+      const auto pos_ms = video_.get(cv::CAP_PROP_POS_MSEC);
+      if (pos_ms > last_media_ms_)
+        *media_ms = pos_ms;
+      break;
+    }
+    case Kind::kImages: {
+      if (index_ >= files_.size())
+        return false;
+      cv::Mat image = cv::imread(files_[index_], cv::IMREAD_COLOR);
+      if (image.empty())
+        return false;
+      image.copyTo(*dst);
+      break;
+    }
+    case Kind::kRawStream:
+      if (!loadRaw(raw_stream_, dst))
+        return false;
+      break;
+    case Kind::kRawFiles: {
+      if (index_ >= files_.size())
+        return false;
+      std::ifstream in(files_[index_], std::ios::binary);
+      if (!loadRaw(in, dst))
+        return false;
+      break;
+    }
+  }
+
+  last_media_ms_ = *media_ms;
+  ++index_;
+  return true;
+}
+
+Frame ReplaySource::acquire() {
+  auto frame = pool_.acquire();
+  if (!frame.empty() || options_.pacing == ReplayPacing::kRealTime)
+    return frame;
+
+  // Unthrottled: wait for the listeners instead of skipping frames, but give
+  // CameraThread a chance to notice a stop request.
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+  while (frame.empty() && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    frame = pool_.acquire();
+  }
+  return frame;
+}
+
+std::int64_t ReplaySource::pace(double media_ms) {
+  const auto now_us = steadyMicros();
+  if (options_.pacing == ReplayPacing::kUnthrottled)
+    return now_us;
+
+  if (!has_base_) {
+    has_base_ = true;
+    wall_base_us_ = now_us;
+    media_base_ms_ = media_ms;
+  }
+
+  const auto target_us = wall_base_us_ + static_cast<std::int64_t>((media_ms - media_base_ms_) * 1000);
+  if (target_us > now_us)
+    std::this_thread::sleep_for(std::chrono::microseconds(target_us - now_us));
+  return target_us;
+}
+
+Frame ReplaySource::read() {
+  if (finished_)
+    return Frame();
+
+  auto frame = acquire();
+  if (frame.empty()) {
+    if (options_.pacing == ReplayPacing::kRealTime) {
+      // Behave like a camera: the frame is skipped, time goes on
+      cv::Mat skipped;
+      double media_ms;
+      if (load(&skipped, &media_ms))
+        pace(media_ms);
+      count_starved();
+    }
+    return frame;
+  }
+
+  auto& buffer = pool_.buffer(frame);
+  double media_ms;
+  if (!load(&buffer, &media_ms)) {
+    if (options_.loop && rewind() && load(&buffer, &media_ms)) {
+      // continue from the first frame
+    } else {
+      finished_ = true;
+      return Frame();
+    }
+  }
+
+  auto& info = pool_.info(frame);
+  info.sequence = sequence_++;
+  info.timestamp_us = pace(media_ms);
+  info.format = format_;
+  info.size = cv::Size(buffer.cols, format_ == PixelFormat::kNV12 ? buffer.rows * 2 / 3 : buffer.rows);
+  return frame;
+}
+
+} // namespace sample
@@ -0,0 +1,96 @@
+/**
+ * Replays recorded frames through the same path as a live camera.
+ *
+ * Accepts
+ *  - a video file readable by cv::VideoCapture,
+ *  - a glob pattern of images, e.g. `frames/img*.png`,
+ *  - raw frames, either one `.raw` file of concatenated frames or a glob pattern of `.raw` files.
+ *    Their geometry is given by ReplayOptions::raw_format, width and height.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_REPLAY_SOURCE_H_
+#define EYEDID_CPP_SAMPLE_REPLAY_SOURCE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "opencv2/opencv.hpp"
+
+#include "frame_pool.h"
+#include "frame_source.h"
+
+namespace sample {
+
+enum class ReplayPacing {
+  /** Deliver frames at their recorded times, dropping frames the listeners are too slow for */
+  kRealTime,
+  /** Deliver every frame as soon as a buffer is free */
+  kUnthrottled,
+};
+
+struct ReplayOptions {
+  std::string path;
+  ReplayPacing pacing = ReplayPacing::kRealTime;
+  /** Frame rate of image and raw sequences, and of videos without timestamps */
+  double fps = 30;
+  /** Start over at the end instead of finishing */
+  bool loop = false;
+
+  /** Raw frame geometry. kBGR, kYUYV or kNV12 */
+  PixelFormat raw_format = PixelFormat::kYUYV;
+  int width = 1280;
+  int height = 720;
+
+  std::size_t pool_size = 8;
+};
+
+class ReplaySource : public FrameSource {
+ public:
+  explicit ReplaySource(ReplayOptions options);
+  ~ReplaySource() override;
+
+  bool open() override;
+  void close() override;
+  Frame read() override;
+  bool finished() const override { return finished_; }
+
+ private:
+  enum class Kind {
+    kVideo,
+    kImages,
+    kRawStream,
+    kRawFiles,
+  };
+
+  Frame acquire();
+  bool load(cv::Mat* dst, double* media_ms);
+  bool loadRaw(std::istream& in, cv::Mat* dst);
+  bool rewind();
+  std::int64_t pace(double media_ms);
+
+  ReplayOptions options_;
+  Kind kind_ = Kind::kVideo;
+  FramePool pool_;
+
+  cv::VideoCapture video_;
+  std::vector<std::string> files_;
+  std::ifstream raw_stream_;
+  int raw_rows_ = 0;
+  int raw_type_ = 0;
+  PixelFormat format_ = PixelFormat::kBGR;
+
+  std::size_t index_ = 0;
+  std::uint64_t sequence_ = 0;
+  double last_media_ms_ = -1;
+  bool has_base_ = false;
+  std::int64_t wall_base_us_ = 0;
+  double media_base_ms_ = 0;
+  bool finished_ = false;
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_REPLAY_SOURCE_H_
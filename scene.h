@@ -0,0 +1,208 @@
+/**
+ * Retained list of drawables of a fixed set of types.
+ *
+ * Elements of each type are stored by value in their own array, so there is no
+ * allocation per element and no virtual call per draw. Each element has a z order;
+ * elements are drawn from the lowest z, ties in the order they were added.
+ *
+ * The scene remembers how every element looked when it was last drawn. collectDirty()
+ * reports the regions that changed since then, and draw() only visits visible elements
+ * whose bounds intersect the region being drawn.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_SCENE_H_
+#define EYEDID_CPP_SAMPLE_SCENE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "opencv2/opencv.hpp"
+
+#include "drawables.h"
+
+namespace sample {
+
+template<typename T, typename... Types>
+struct type_index;
+
+template<typename T, typename... Types>
+struct type_index<T, T, Types...> : std::integral_constant<std::size_t, 0> {};
+
+template<typename T, typename U, typename... Types>
+struct type_index<T, U, Types...> : std::integral_constant<std::size_t, 1 + type_index<T, Types...>::value> {};
+
+template<typename... Types>
+class Scene {
+ public:
+  /** Handle to an element. Stays valid for the lifetime of the scene */
+  template<typename T>
+  struct Id {
+    std::uint32_t index = 0;
+  };
+
+  Scene() = default;
+
+  Scene(const Scene&) = delete;
+  Scene& operator=(const Scene&) = delete;
+
+  template<typename T>
+  Id<T> add(T element, int z = 0) {
+    auto& entries = entriesOf<T>();
+    Entry<T> entry;
+    entry.element = std::move(element);
+    // Not drawn yet, so a visible element is reported as changed
+    entry.drawn = entry.element;
+    entry.drawn.visible = false;
+    entries.push_back(std::move(entry));
+
+    Id<T> id;
+    id.index = static_cast<std::uint32_t>(entries.size() - 1);
+    order_.push_back({z, static_cast<std::uint8_t>(type_index<T, Types...>::value), id.index, next_seq_++});
+    restack_ = true;
+    return id;
+  }
+
+  /** The element may be modified freely; changes are found by collectDirty() */
+  template<typename T>
+  T& operator[](Id<T> id) { return entriesOf<T>()[id.index].element; }
+
+  template<typename T>
+  const T& operator[](Id<T> id) const { return entriesOf<T>()[id.index].element; }
+
+  template<typename T>
+  void setZ(Id<T> id, int z) {
+    const auto type = static_cast<std::uint8_t>(type_index<T, Types...>::value);
+    for (auto& ref : order_) {
+      if (ref.type == type && ref.index == id.index && ref.z != z) {
+        ref.z = z;
+        entriesOf<T>()[id.index].moved = true;
+        restack_ = true;
+      }
+    }
+  }
+
+  std::size_t size() const { return order_.size(); }
+
+  /**
+   * Pass every region that changed since the last call to `add`, and take the
+   * current state of the elements as drawn. Call before draw().
+   */
+  template<typename F>
+  void collectDirty(F&& add) {
+    using expand = int[];
+    (void)expand{0, (collectDirtyOf<Types>(add), 0)...};
+
+    if (restack_) {
+      std::stable_sort(order_.begin(), order_.end(), [](const Ref& a, const Ref& b) {
+        return a.z != b.z ? a.z < b.z : a.seq < b.seq;
+      });
+      visible_.clear();
+      static const VisibleFn visible_fns[] = {&Scene::isVisible<Types>...};
+      for (const auto& ref : order_) {
+        if ((this->*visible_fns[ref.type])(ref.index))
+          visible_.push_back(ref);
+      }
+      restack_ = false;
+    }
+  }
+
+  /**
+   * Draw the visible elements that intersect `region` into `dst`, in z order.
+   * @param dst     the pixels of `region`
+   * @param region  view coordinates of `dst`
+   */
+  void draw(cv::Mat* dst, const cv::Rect& region) const {
+    // Runs of one type are drawn by one typed loop
+    static const DrawRunFn draw_fns[] = {&Scene::drawRun<Types>...};
+    for (auto first = visible_.begin(); first != visible_.end();) {
+      auto last = first + 1;
+      while (last != visible_.end() && last->type == first->type)
+        ++last;
+      (this->*draw_fns[first->type])(&*first, &*first + (last - first), dst, region);
+      first = last;
+    }
+  }
+
+ private:
+  template<typename T>
+  struct Entry {
+    T element;
+    /** The element as of the last collectDirty() */
+    T drawn;
+    /** drawn.bounds(), which may be expensive to compute */
+    cv::Rect bounds;
+    /** The z order changed since the last collectDirty() */
+    bool moved = false;
+  };
+
+  struct Ref {
+    int z;
+    std::uint8_t type;
+    std::uint32_t index;
+    std::uint64_t seq;
+  };
+
+  using VisibleFn = bool (Scene::*)(std::uint32_t) const;
+  using DrawRunFn = void (Scene::*)(const Ref*, const Ref*, cv::Mat*, const cv::Rect&) const;
+
+  template<typename T>
+  std::vector<Entry<T>>& entriesOf() {
+    return std::get<type_index<T, Types...>::value>(entries_);
+  }
+
+  template<typename T>
+  const std::vector<Entry<T>>& entriesOf() const {
+    return std::get<type_index<T, Types...>::value>(entries_);
+  }
+
+  template<typename T, typename F>
+  void collectDirtyOf(F& add) {
+    for (auto& entry : entriesOf<T>()) {
+      if (entry.moved) {
+        // Elements above or below it may now show through
+        if (entry.drawn.visible)
+          add(entry.bounds);
+        entry.moved = false;
+      }
+      const bool was_visible = entry.drawn.visible;
+      if (!drawables::forEachChange(entry.element, entry.drawn, add))
+        continue;
+      entry.drawn = entry.element;
+      entry.bounds = entry.element.bounds();
+      if (was_visible != entry.drawn.visible)
+        restack_ = true;
+    }
+  }
+
+  template<typename T>
+  bool isVisible(std::uint32_t index) const {
+    return entriesOf<T>()[index].drawn.visible;
+  }
+
+  template<typename T>
+  void drawRun(const Ref* first, const Ref* last, cv::Mat* dst, const cv::Rect& region) const {
+    const auto& entries = entriesOf<T>();
+    for (; first != last; ++first) {
+      const auto& entry = entries[first->index];
+      if (!(entry.bounds & region).empty())
+        entry.drawn.draw(dst, region.tl());
+    }
+  }
+
+  std::tuple<std::vector<Entry<Types>>...> entries_;
+  /** Every element, in z order once restacked */
+  std::vector<Ref> order_;
+  /** Visible elements in z order */
+  std::vector<Ref> visible_;
+  std::uint64_t next_seq_ = 0;
+  bool restack_ = false;
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_SCENE_H_
@@ -1,37 +1,85 @@
 /**
  * Created by YongGyu Lee on 2021/09/16.
  *
- * Simple imitation of boost::signal without grouping, etc
+ * Simple imitation of boost::signal, with slots called in priority groups
+ * (realtime, default, background) and connections that can be queued to an event_loop
  */
 
 #ifndef EYEDID_CPP_SAMPLE_SIMPLE_SIGNAL_H_
 #define EYEDID_CPP_SAMPLE_SIMPLE_SIGNAL_H_
 
-#include <list>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <memory>
 #include <mutex>
+#include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "event_loop.h"
+#include "inplace_function.h"
+#include "latency_stats.h"
+#include "timestamp.h"
 
 namespace sample {
 
 template<typename F>
 class signal;
 
+/**
+ * Slots are called group by group in this order, and in connection order within a group.
+ * Put slots that hand data to a latency-critical consumer in kRealtime.
+ */
+enum class slot_group {
+  kRealtime,
+  kDefault,
+  kBackground,
+};
+
+constexpr std::size_t kSlotGroupCount = 3;
+
 class slot_base {
  public:
-  ~slot_base() = default;
+  virtual ~slot_base() = default;
   virtual void expire() = 0;
 };
 
+/** The part of a signal that its connections refer to */
+class signal_core_base {
+ public:
+  virtual ~signal_core_base() = default;
+
+  /** Publish the slots without the expired ones, and free them once no emission uses them */
+  virtual void remove_expired() = 0;
+};
+
+/**
+ * A connected function, stored inline, and the optional target whose lifetime it follows.
+ */
 template<typename R, typename ...Args>
 class slot : public slot_base {
  public:
-  template<typename F2>
-  explicit slot(const F2& func) : func_(func) {}
+  using function_type = inplace_function<R(Args...)>;
 
+  explicit slot(function_type func, slot_group group = slot_group::kDefault)
+    : func_(std::move(func)), group_(group) {}
+
+  slot(function_type func, std::weak_ptr<void> track, slot_group group = slot_group::kDefault)
+    : func_(std::move(func)), tracked_(true), group_(group), track_(std::move(track)) {}
+
+  /** Does nothing if the tracked target is gone */
   template<typename ...Ts>
-  R operator()(Ts&&... args) const {
-    return func_(std::forward<Ts>(args)...);
+  void operator()(Ts&&... args) const {
+    if (tracked_) {
+      const auto target = track_.lock();
+      if (target)
+        func_(std::forward<Ts>(args)...);
+      return;
+    }
+    func_(std::forward<Ts>(args)...);
   }
 
   void expire() override {
@@ -42,9 +90,151 @@ class slot : public slot_base {
     return expired_;
   }
 
+  slot_group group() const {
+    return group_;
+  }
+
  private:
+  function_type func_;
+  bool tracked_ = false;
   std::atomic_bool expired_{false};
-  std::function<R(Args...)> func_;
+  slot_group group_;
+  std::weak_ptr<void> track_;
+};
+
+/**
+ * What a queued connection does with a call when its queue is full.
+ * The emitting thread never waits for the target loop.
+ */
+enum class queue_policy {
+  /** Discard the oldest queued call */
+  kDropOldest,
+  /** Discard the new call */
+  kDropNewest,
+  /** Keep only the newest call. For high-rate state updates such as gaze points */
+  kLatestOnly,
+};
+
+template<std::size_t ...I>
+struct index_sequence {};
+
+template<std::size_t N, std::size_t ...I>
+struct make_index_sequence : make_index_sequence<N - 1, N - 1, I...> {};
+
+template<std::size_t ...I>
+struct make_index_sequence<0, I...> : index_sequence<I...> {};
+
+/**
+ * The receiving end of a queued connection.
+ *
+ * Emission copies the arguments into a bounded queue of the connection's own, and posts
+ * one task to the target loop if none is pending yet. The task calls the function once
+ * for every queued call. Arguments are stored decayed, so references are copied.
+ */
+template<typename ...Args>
+class queued_call : public std::enable_shared_from_this<queued_call<Args...>> {
+ public:
+  using function_type = inplace_function<void(Args...)>;
+  using args_type = std::tuple<typename std::decay<Args>::type...>;
+
+  queued_call(function_type func, event_loop& loop, queue_policy policy, std::size_t capacity)
+    : func_(std::move(func)), loop_(loop), policy_(policy),
+      queue_(policy == queue_policy::kLatestOnly ? 1 : capacity) {}
+
+  void track(std::weak_ptr<void> target) {
+    tracked_ = true;
+    track_ = std::move(target);
+  }
+
+  /** The slot the connection disconnects; calls still queued are dropped with it */
+  void owner(std::weak_ptr<slot<void, Args...>> slot) {
+    owner_ = std::move(slot);
+  }
+
+  /** Called on the emitting thread */
+  template<typename ...Ts>
+  void push(Ts&&... args) {
+    args_type value(std::forward<Ts>(args)...);
+    switch (policy_) {
+      case queue_policy::kDropNewest:
+        if (!queue_.try_push(std::move(value)))
+          dropped_.fetch_add(1, std::memory_order_relaxed);
+        break;
+      case queue_policy::kLatestOnly:
+        drop_queued();
+        // Another emitter may have refilled it; then that call is as new as this one
+        if (!queue_.try_push(std::move(value)))
+          dropped_.fetch_add(1, std::memory_order_relaxed);
+        break;
+      case queue_policy::kDropOldest:
+        while (!queue_.try_push(value)) {
+          args_type oldest;
+          if (queue_.try_pop(oldest))
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        break;
+    }
+    schedule();
+  }
+
+  std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  void schedule() {
+    if (scheduled_.exchange(true, std::memory_order_acq_rel))
+      return;
+    auto self = this->shared_from_this();
+    if (!loop_.post([self]() { self->dispatch(); })) {
+      // The loop is saturated; the calls stay queued until the next emission
+      scheduled_.store(false, std::memory_order_release);
+    }
+  }
+
+  /** Called on the target loop */
+  void dispatch() {
+    // Cleared first, so that a call queued while draining posts another dispatch
+    scheduled_.store(false, std::memory_order_seq_cst);
+
+    const auto slot = owner_.lock();
+    if (!slot || slot->expired()) {
+      drop_queued();
+      return;
+    }
+    std::shared_ptr<void> target;
+    if (tracked_) {
+      target = track_.lock();
+      if (!target) {
+        drop_queued();
+        return;
+      }
+    }
+
+    args_type value;
+    while (queue_.try_pop(value))
+      call(value, make_index_sequence<sizeof...(Args)>());
+  }
+
+  template<std::size_t ...I>
+  void call(args_type& value, index_sequence<I...>) {
+    func_(std::get<I>(value)...);
+  }
+
+  void drop_queued() {
+    args_type value;
+    while (queue_.try_pop(value))
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  function_type func_;
+  event_loop& loop_;
+  const queue_policy policy_;
+  bounded_queue<args_type> queue_;
+  std::atomic_bool scheduled_{false};
+  std::atomic<std::uint64_t> dropped_{0};
+
+  bool tracked_ = false;
+  std::weak_ptr<void> track_;
+  std::weak_ptr<slot<void, Args...>> owner_;
 };
 
 /**
@@ -55,26 +245,31 @@ class connection {
  public:
   connection() = default;
 
+  /**
+   * The slot is not called by emissions that start after this returns. The signal releases
+   * it, with everything its function captured, right away; or, if an emission is running,
+   * at the next connect() or disconnect() that finds none running.
+   */
   void disconnect() {
     auto lock_ptr = slot_ptr_.lock();
-    if (lock_ptr) {
-      lock_ptr->expire();
-    }
+    if (!lock_ptr)
+      return;
+    lock_ptr->expire();
+    lock_ptr.reset();
+
+    const auto core = core_.lock();
+    if (core)
+      core->remove_expired();
   }
 
  private:
   template<typename F> friend class signal;
 
-  template<typename ...T>
-  explicit connection(std::shared_ptr<slot<T...>> ptr) : slot_ptr_(std::move(ptr)) {}
-
-  template<typename ...T>
-  connection& operator=(std::shared_ptr<slot<T...>> ptr) {
-    slot_ptr_ = std::move(ptr);
-    return *this;
-  }
+  connection(std::weak_ptr<slot_base> slot, std::weak_ptr<signal_core_base> core)
+    : slot_ptr_(std::move(slot)), core_(std::move(core)) {}
 
   std::weak_ptr<slot_base> slot_ptr_;
+  std::weak_ptr<signal_core_base> core_;
 };
 
 /**
@@ -107,15 +302,33 @@ class raii_connection {
  * Can connect(register) functions and notify connected functions.
  * One must store connection from signal::connect in order to disconnect(unregister) it later.
  *
+ * Emission iterates an immutable snapshot of the slots taken with one atomic load, so
+ * emitters never take the connect mutex and a slot may connect or disconnect while being
+ * called. connect() and disconnect() publish a new snapshot without the disconnected slots;
+ * emission only skips them. A replaced snapshot, and the slots only it holds, is freed
+ * right away if no emission is running, and otherwise by the next connect() or disconnect()
+ * that finds none running.
+ *
+ * A function connected with an event_loop is queued instead: it runs on the loop's thread,
+ * and the emitting thread only copies the arguments. See queue_policy.
+ *
+ * Slots run in slot_group order. Connecting a kBackground slot with an event_loop defers
+ * its work off the emitting thread entirely.
+ *
  * @tparam R        return type
  * @tparam Args     argument type
  */
 template<typename R, typename ...Args>
 class signal<R(Args...)> {
  public:
-  using function_type = std::function<R(Args...)>;
   using slot_type = slot<R, Args...>;
-  using slot_list = std::list<std::shared_ptr<slot_type>>;
+  using function_type = typename slot_type::function_type;
+  using slot_list = std::vector<std::shared_ptr<slot_type>>;
+
+  signal() = default;
+
+  signal(const signal&) = delete;
+  signal& operator=(const signal&) = delete;
 
   /**
    * Connect a function
@@ -123,13 +336,12 @@ class signal<R(Args...)> {
    * @return connection
    */
   connection connect(function_type func) {
-    auto new_slot = std::make_shared<slot_type>(std::move(func));
-    {
-      std::lock_guard<std::mutex> lck(connect_mutex_);
-      slot_list_.emplace_back(new_slot);
-    }
+    return connect(slot_group::kDefault, std::move(func));
+  }
 
-    return connection(new_slot);
+  /** Connect a function to a group */
+  connection connect(slot_group group, function_type func) {
+    return add(std::make_shared<slot_type>(std::move(func), group));
   }
 
   /**
@@ -143,13 +355,52 @@ class signal<R(Args...)> {
    */
   template<typename T>
   connection connect(function_type func, std::shared_ptr<T> track) {
-    std::weak_ptr<void> weak_ptr = std::move(track);
-    return connect([=](Args&&... args) {
-      auto lck = weak_ptr.lock();
-      if (lck) {
-        func(std::forward<Args>(args)...);
-      }
-    });
+    return connect(slot_group::kDefault, std::move(func), std::move(track));
+  }
+
+  template<typename T>
+  connection connect(slot_group group, function_type func, std::shared_ptr<T> track) {
+    return add(std::make_shared<slot_type>(std::move(func), std::weak_ptr<void>(std::move(track)), group));
+  }
+
+  /**
+   * Connect a function that runs on `loop` instead of the emitting thread.
+   * `loop` must outlive the connection.
+   *
+   * @param func
+   * @param loop      where `func` runs
+   * @param policy    what to do when `capacity` calls are waiting
+   * @param capacity  calls queued at most; 1 for kLatestOnly
+   * @return connection
+   */
+  connection connect(typename queued_call<Args...>::function_type func, event_loop& loop,
+                     queue_policy policy, std::size_t capacity = 16) {
+    return connect(slot_group::kDefault, std::move(func), loop, policy, capacity);
+  }
+
+  connection connect(slot_group group, typename queued_call<Args...>::function_type func, event_loop& loop,
+                     queue_policy policy, std::size_t capacity = 16) {
+    return add_queued(group, std::make_shared<queued_call<Args...>>(std::move(func), loop, policy, capacity),
+                     std::weak_ptr<void>(), false);
+  }
+
+  /**
+   * Connect a function that runs on `loop`, while the tracking target is alive.
+   * The target is checked again on the loop before the call.
+   */
+  template<typename T>
+  connection connect(typename queued_call<Args...>::function_type func, std::shared_ptr<T> track,
+                     event_loop& loop, queue_policy policy, std::size_t capacity = 16) {
+    return connect(slot_group::kDefault, std::move(func), std::move(track), loop, policy, capacity);
+  }
+
+  template<typename T>
+  connection connect(slot_group group, typename queued_call<Args...>::function_type func, std::shared_ptr<T> track,
+                     event_loop& loop, queue_policy policy, std::size_t capacity = 16) {
+    auto call = std::make_shared<queued_call<Args...>>(std::move(func), loop, policy, capacity);
+    std::weak_ptr<void> target(std::move(track));
+    call->track(target);
+    return add_queued(group, std::move(call), std::move(target), true);
   }
 
   /**
@@ -159,25 +410,137 @@ class signal<R(Args...)> {
    */
   template<typename ...Args2>
   void operator()(Args2&&... args) {
-    std::unique_lock<std::mutex> lck(connect_mutex_);
-    auto it = slot_list_.begin();
+    const emission_guard guard(core_->emitting_);
+    const auto* slots = core_->slots_.load(std::memory_order_seq_cst);
+    if (!slots)
+      return;
+    if (measured_.load(std::memory_order_relaxed)) {
+      emit_measured(*slots, args...);
+      return;
+    }
+    for (const auto& s : *slots) {
+      if (!s->expired())
+        (*s)(args...);
+    }
+  }
 
-    while (it != slot_list_.end()) {
-      if ((*it)->expired()) {
-        it = slot_list_.erase(it);
+  /**
+   * Measure how long each group waits for the groups before it, from the start of an
+   * emission to its first slot. Off by default, as it reads the clock per group.
+   */
+  void measure_groups(bool enable) {
+    measured_.store(enable, std::memory_order_relaxed);
+  }
+
+  LatencyStats::Snapshot group_latency(slot_group group) const {
+    return group_latency_[static_cast<std::size_t>(group)].snapshot();
+  }
+
+ private:
+  connection add_queued(slot_group group, std::shared_ptr<queued_call<Args...>> call,
+                       std::weak_ptr<void> track, bool tracked) {
+    static_assert(std::is_void<R>::value, "queued connections cannot return a value");
+    auto* receiver = call.get();
+    auto forward = [call](Args... args) {
+      call->push(std::forward<Args>(args)...);
+    };
+    auto new_slot = tracked ?
+      std::make_shared<slot_type>(std::move(forward), std::move(track), group) :
+      std::make_shared<slot_type>(std::move(forward), group);
+    // The slot owns the receiver, which only refers back weakly
+    receiver->owner(new_slot);
+    return add(std::move(new_slot));
+  }
+
+  connection add(std::shared_ptr<slot_type> new_slot) {
+    core_->insert(new_slot);
+    return connection(new_slot, core_);
+  }
+
+  template<typename ...Args2>
+  void emit_measured(const slot_list& slots, Args2&... args) {
+    const auto start_us = steadyMicros();
+    std::size_t group = kSlotGroupCount;
+    for (const auto& s : slots) {
+      if (s->expired())
         continue;
+      const auto g = static_cast<std::size_t>(s->group());
+      if (g != group) {
+        group = g;
+        group_latency_[g].add(steadyMicros() - start_us);
       }
-
-      lck.unlock();
-      (**it)(args...);
-      lck.lock();
-      ++it;
+      (*s)(args...);
     }
   }
 
- private:
-  mutable std::mutex connect_mutex_;
-  slot_list slot_list_;
+  struct emission_guard {
+    explicit emission_guard(std::atomic_int& count) : count_(count) {
+      count_.fetch_add(1, std::memory_order_seq_cst);
+    }
+    ~emission_guard() { count_.fetch_sub(1, std::memory_order_release); }
+
+    std::atomic_int& count_;
+  };
+
+  /**
+   * The slots and their snapshots. Connections refer to it weakly, so they can disconnect
+   * without keeping the signal alive.
+   */
+  class core : public signal_core_base {
+   public:
+    ~core() override { delete slots_.load(std::memory_order_relaxed); }
+
+    void insert(const std::shared_ptr<slot_type>& new_slot) {
+      std::lock_guard<std::mutex> lck(mutex_);
+      publish([&new_slot](slot_list& slots) {
+        // After the last slot of the same or an earlier group
+        const auto position = std::upper_bound(slots.begin(), slots.end(), new_slot->group(),
+          [](slot_group group, const std::shared_ptr<slot_type>& s) { return group < s->group(); });
+        slots.insert(position, new_slot);
+      });
+    }
+
+    void remove_expired() override {
+      std::lock_guard<std::mutex> lck(mutex_);
+      publish([](slot_list&) {});
+    }
+
+    std::atomic<const slot_list*> slots_{nullptr};
+    std::atomic_int emitting_{0};
+
+   private:
+    /** Publish the live slots, changed by `edit`, and retire the current snapshot. Call with mutex_ held */
+    template<typename F>
+    void publish(F&& edit) {
+      std::unique_ptr<slot_list> slots(new slot_list());
+      const auto* current = slots_.load(std::memory_order_relaxed);
+      if (current) {
+        slots->reserve(current->size() + 1);
+        for (const auto& s : *current) {
+          if (!s->expired())
+            slots->push_back(s);
+        }
+      }
+      edit(*slots);
+      slots_.store(slots.release(), std::memory_order_seq_cst);
+      if (current)
+        retired_.emplace_back(current);
+
+      // Emissions starting from now load the new snapshot, so if none is running,
+      // nobody can still be iterating a retired one
+      if (emitting_.load(std::memory_order_seq_cst) == 0)
+        retired_.clear();
+    }
+
+    // Serializes connect() and disconnect(); emission does not use it
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<const slot_list>> retired_;
+  };
+
+  std::shared_ptr<core> core_ = std::make_shared<core>();
+
+  std::atomic_bool measured_{false};
+  LatencyStats group_latency_[kSlotGroupCount];
 };
 
 } // namespace sample
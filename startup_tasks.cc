@@ -0,0 +1,136 @@
+#include "startup_tasks.h"
+
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+#include "timestamp.h"
+
+namespace sample {
+
+std::size_t StartupTasks::add(std::string name, function_type func, std::vector<std::size_t> deps, Affinity affinity) {
+  Task task;
+  task.name = std::move(name);
+  task.func = std::move(func);
+  task.deps = std::move(deps);
+  task.affinity = affinity;
+  tasks_.push_back(std::move(task));
+  return tasks_.size() - 1;
+}
+
+bool StartupTasks::run() {
+  run_start_us_ = steadyMicros();
+
+  std::unique_lock<std::mutex> lck(mutex_);
+  schedule();
+  while (finished_ < tasks_.size()) {
+    if (main_queue_.empty()) {
+      cv_.wait(lck);
+      continue;
+    }
+
+    const auto id = main_queue_.front();
+    main_queue_.pop_front();
+    lck.unlock();
+    execute(id);
+    lck.lock();
+  }
+  lck.unlock();
+
+  for (auto& thread : threads_)
+    thread.join();
+  threads_.clear();
+  run_end_us_ = steadyMicros();
+
+  for (const auto& task : tasks_) {
+    if (task.state != State::kSucceeded)
+      return false;
+  }
+  return true;
+}
+
+void StartupTasks::execute(std::size_t id) {
+  auto& task = tasks_[id];
+  task.start_us = steadyMicros();
+
+  bool succeeded = false;
+  try {
+    succeeded = task.func();
+  } catch (const std::exception& e) {
+    std::cerr << "Startup task '" << task.name << "' failed: " << e.what() << '\n';
+  }
+
+  task.end_us = steadyMicros();
+  std::lock_guard<std::mutex> lck(mutex_);
+  finish(id, succeeded);
+}
+
+void StartupTasks::schedule() {
+  for (std::size_t id = 0; id < tasks_.size(); ++id) {
+    auto& task = tasks_[id];
+    if (task.state != State::kPending)
+      continue;
+
+    bool ready = true;
+    bool skip = false;
+    for (const auto dep : task.deps) {
+      const auto state = tasks_[dep].state;
+      if (state == State::kFailed || state == State::kSkipped)
+        skip = true;
+      else if (state != State::kSucceeded)
+        ready = false;
+    }
+
+    if (skip) {
+      // Dependencies come before their dependents, so later tasks see this in the same pass
+      task.state = State::kSkipped;
+      ++finished_;
+      continue;
+    }
+    if (!ready)
+      continue;
+
+    task.state = State::kRunning;
+    if (task.affinity == Affinity::kMain)
+      main_queue_.push_back(id);
+    else
+      threads_.emplace_back([this, id]() { execute(id); });
+  }
+  cv_.notify_all();
+}
+
+void StartupTasks::finish(std::size_t id, bool succeeded) {
+  tasks_[id].state = succeeded ? State::kSucceeded : State::kFailed;
+  ++finished_;
+  schedule();
+}
+
+void StartupTasks::printReport(std::ostream& os) const {
+  const auto ms = [](std::int64_t us) { return static_cast<double>(us) / 1000.0; };
+
+  // Formatted apart, so that the caller's stream keeps its precision
+  std::ostringstream out;
+  std::int64_t busy_us = 0;
+  out << "Startup" << std::fixed << std::setprecision(1) << '\n';
+  for (const auto& task : tasks_) {
+    out << "  " << std::left << std::setw(16) << task.name << std::right;
+    switch (task.state) {
+      case State::kSucceeded:
+      case State::kFailed:
+        out << " +" << std::setw(7) << ms(task.start_us - run_start_us_) << "ms "
+            << std::setw(7) << ms(task.end_us - task.start_us) << "ms"
+            << (task.state == State::kFailed ? " failed" : "") << '\n';
+        busy_us += task.end_us - task.start_us;
+        break;
+      default:
+        out << " skipped\n";
+        break;
+    }
+  }
+  out << "  total " << ms(run_end_us_ - run_start_us_) << "ms, " << ms(busy_us) << "ms if run one after another\n";
+  os << out.str();
+}
+
+} // namespace sample
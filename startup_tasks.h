@@ -0,0 +1,83 @@
+/**
+ * Runs startup steps concurrently, each as soon as the steps it depends on are done.
+ *
+ * Loading the SDK, license authentication, camera warm-up and window creation are
+ * slow and mostly independent. Declaring them as tasks with explicit dependencies
+ * lets them overlap, and the report shows where startup time goes.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_STARTUP_TASKS_H_
+#define EYEDID_CPP_SAMPLE_STARTUP_TASKS_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sample {
+
+class StartupTasks {
+ public:
+  using function_type = std::function<bool()>;
+
+  enum class Affinity {
+    /** Runs on a thread of its own */
+    kWorker,
+    /** Runs on the thread that calls run(), e.g. for GUI calls */
+    kMain,
+  };
+
+  /**
+   * Add a task. Tasks can only depend on tasks added before them.
+   * @param func  returns false on failure. Tasks depending on a failed task are skipped
+   * @return id to use in `deps` of later tasks
+   */
+  std::size_t add(std::string name, function_type func,
+                  std::vector<std::size_t> deps = {}, Affinity affinity = Affinity::kWorker);
+
+  /**
+   * Run every task and wait until all of them finished or were skipped.
+   * @return true if every task succeeded
+   */
+  bool run();
+
+  /** Start offset and duration of each task, in milliseconds */
+  void printReport(std::ostream& os) const;
+
+ private:
+  enum class State { kPending, kRunning, kSucceeded, kFailed, kSkipped };
+
+  struct Task {
+    std::string name;
+    function_type func;
+    std::vector<std::size_t> deps;
+    Affinity affinity;
+    State state = State::kPending;
+    std::int64_t start_us = 0;
+    std::int64_t end_us = 0;
+  };
+
+  void execute(std::size_t id);
+  void schedule();
+  void finish(std::size_t id, bool succeeded);
+
+  std::vector<Task> tasks_;
+  std::int64_t run_start_us_ = 0;
+  std::int64_t run_end_us_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::size_t finished_ = 0;
+  std::deque<std::size_t> main_queue_;
+  std::vector<std::thread> threads_;
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_STARTUP_TASKS_H_
@@ -0,0 +1,34 @@
+/**
+ * Minimal assertion helper for the test executables.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_TESTS_CHECK_H_
+#define EYEDID_CPP_SAMPLE_TESTS_CHECK_H_
+
+#include <cstdlib>
+#include <iostream>
+
+inline int& check_failures() {
+  static int failures = 0;
+  return failures;
+}
+
+/** Report a failed condition and keep going */
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      std::cerr << __FILE__ << ':' << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+      ++check_failures(); \
+    } \
+  } while (false)
+
+/** Exit code for main() */
+inline int check_result() {
+  if (check_failures() > 0) {
+    std::cerr << check_failures() << " check(s) failed\n";
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+#endif // EYEDID_CPP_SAMPLE_TESTS_CHECK_H_
@@ -0,0 +1,121 @@
+/**
+ * Checks which frames FrameAdmission lets through to the SDK, and that it stops skipping
+ * whenever skipping would lose a frame the SDK would have accepted.
+ */
+
+#include <cstdint>
+
+#include "frame_admission.h"
+
+#include "check.h"
+
+namespace {
+
+const std::int64_t kInterval30us = 1000000 / 30;
+
+/** Admit the frame and, if admitted, report it as the SDK decided */
+bool offer(sample::FrameAdmission* admission, std::int64_t timestamp_us, bool accepted = true) {
+  if (!admission->admit(timestamp_us))
+    return false;
+  admission->report(timestamp_us, accepted);
+  return true;
+}
+
+void testUnlimited() {
+  sample::FrameAdmission admission(0);
+  for (int i = 0; i < 10; ++i)
+    CHECK(offer(&admission, i * 1000));
+  CHECK(admission.stats().admitted == 10);
+  CHECK(admission.stats().skipped == 0);
+}
+
+void testFasterCamera() {
+  // A 60 fps camera against a 30 fps limit: every other frame is converted
+  sample::FrameAdmission admission(30);
+  const std::int64_t interval_us = 1000000 / 60;
+  int admitted = 0;
+  for (int i = 0; i < 60; ++i)
+    admitted += offer(&admission, i * interval_us) ? 1 : 0;
+  CHECK(admitted == 30);
+  CHECK(admission.stats().admitted == 30);
+  CHECK(admission.stats().skipped == 30);
+}
+
+void testSlowerOrJitteryCamera() {
+  // Frames the SDK would take are never skipped: a camera below the limit...
+  sample::FrameAdmission admission(30);
+  for (int i = 0; i < 25; ++i)
+    CHECK(offer(&admission, i * (1000000 / 25)));
+
+  // ...or one at the limit that arrives a little early now and then
+  sample::FrameAdmission jittery(30);
+  std::int64_t timestamp_us = 0;
+  for (int i = 0; i < 30; ++i) {
+    timestamp_us += kInterval30us + (i % 2 == 0 ? -2000 : 2000);
+    CHECK(offer(&jittery, timestamp_us));
+  }
+  CHECK(jittery.stats().skipped == 0);
+}
+
+void testRejectedFrameDoesNotCount() {
+  // A frame the SDK omitted is no reason to skip the next one
+  sample::FrameAdmission admission(30);
+  CHECK(offer(&admission, 0));
+  CHECK(offer(&admission, kInterval30us, false));
+  CHECK(offer(&admission, kInterval30us + 1000));
+  CHECK(admission.stats().rejected == 1);
+}
+
+void testRejectionTightens() {
+  sample::FrameAdmission admission(30);
+  CHECK(offer(&admission, 0));
+  // Within the initial tolerance of an eighth of a frame, but the SDK omits it
+  const std::int64_t early_us = kInterval30us - kInterval30us / 8 + 100;
+  CHECK(offer(&admission, early_us, false));
+  // The tolerance halved, so a frame that early is now skipped, and a later one is not
+  CHECK(!admission.admit(early_us + 100));
+  CHECK(offer(&admission, kInterval30us - kInterval30us / 16 + 100));
+}
+
+void testDropTightens() {
+  sample::FrameAdmission admission(30);
+  CHECK(offer(&admission, 0));
+  admission.drop();
+  CHECK(admission.stats().dropped == 1);
+  CHECK(!admission.admit(kInterval30us - kInterval30us / 8 + 100));
+}
+
+void testToleranceIsBounded() {
+  // Accepted frames relax the tolerance, but never beyond half a frame
+  sample::FrameAdmission admission(30);
+  std::int64_t timestamp_us = 0;
+  for (int i = 0; i < 1000; ++i, timestamp_us += kInterval30us)
+    CHECK(offer(&admission, timestamp_us));
+  const auto last_us = timestamp_us - kInterval30us;
+  CHECK(!admission.admit(last_us + kInterval30us / 2 - 1000));
+  CHECK(admission.admit(last_us + kInterval30us / 2 + 1000));
+}
+
+void testSetFps() {
+  sample::FrameAdmission admission(30);
+  CHECK(offer(&admission, 0));
+  CHECK(!admission.admit(1000));
+  // Lifting the limit admits every frame right away
+  admission.setFps(0);
+  CHECK(offer(&admission, 2000));
+  CHECK(offer(&admission, 3000));
+}
+
+} // namespace
+
+int main() {
+  testUnlimited();
+  testFasterCamera();
+  testSlowerOrJitteryCamera();
+  testRejectedFrameDoesNotCount();
+  testRejectionTightens();
+  testDropTightens();
+  testToleranceIsBounded();
+  testSetFps();
+  return check_result();
+}
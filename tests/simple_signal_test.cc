@@ -0,0 +1,125 @@
+/**
+ * Connection lifetime and call order of sample::signal.
+ */
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "event_loop.h"
+#include "simple_signal.h"
+
+#include "check.h"
+
+namespace {
+
+void testDisconnectReleasesSlot() {
+  sample::signal<void(int)> sig;
+  auto captured = std::make_shared<int>(0);
+  std::weak_ptr<int> watch = captured;
+
+  auto conn = sig.connect([captured](int v) { *captured += v; });
+  captured.reset();
+  sig(1);
+  CHECK(!watch.expired());
+  CHECK(*watch.lock() == 1);
+
+  conn.disconnect();
+  CHECK(watch.expired());
+  sig(1);
+}
+
+void testDisconnectWhileEmitting() {
+  sample::signal<void()> sig;
+  auto captured = std::make_shared<int>(0);
+  std::weak_ptr<int> watch = captured;
+
+  int calls = 0;
+  sample::connection conn;
+  conn = sig.connect([captured, &conn, &calls]() {
+    ++calls;
+    // The running emission still holds the slot
+    conn.disconnect();
+    CHECK(*captured == 0);
+  });
+  captured.reset();
+
+  sig();
+  sig();
+  CHECK(calls == 1);
+  // Freed by the next connect() once no emission runs
+  sig.connect([]() {});
+  CHECK(watch.expired());
+}
+
+void testOutlivesSignal() {
+  sample::connection conn;
+  {
+    sample::signal<void()> sig;
+    conn = sig.connect([]() {});
+  }
+  conn.disconnect();
+}
+
+void testGroupOrder() {
+  sample::signal<void()> sig;
+  std::string order;
+  sig.connect(sample::slot_group::kBackground, [&order]() { order += 'b'; });
+  sig.connect([&order]() { order += 'd'; });
+  sig.connect(sample::slot_group::kRealtime, [&order]() { order += 'r'; });
+  sig.connect(sample::slot_group::kRealtime, [&order]() { order += 'R'; });
+  sig();
+  CHECK(order == "rRdb");
+}
+
+void testQueued() {
+  sample::signal<void(int)> sig;
+  sample::event_loop loop;
+  std::vector<int> received;
+  sig.connect([&received](int v) { received.push_back(v); }, loop, sample::queue_policy::kDropOldest, 4);
+
+  for (int i = 0; i < 6; ++i)
+    sig(i);
+  CHECK(received.empty());
+  loop.run_pending();
+  CHECK((received == std::vector<int>{2, 3, 4, 5}));
+}
+
+void testConcurrentDisconnect() {
+  sample::signal<void()> sig;
+  std::atomic_bool stop{false};
+  std::thread emitter([&]() {
+    while (!stop.load())
+      sig();
+  });
+
+  for (int i = 0; i < 2000; ++i) {
+    auto captured = std::make_shared<int>(i);
+    auto conn = sig.connect([captured]() { static_cast<void>(*captured); });
+    captured.reset();
+    conn.disconnect();
+  }
+  stop = true;
+  emitter.join();
+
+  // Nothing is emitting anymore, so the next change frees every retired snapshot
+  auto captured = std::make_shared<int>(0);
+  std::weak_ptr<int> watch = captured;
+  sig.connect([captured]() {}).disconnect();
+  captured.reset();
+  CHECK(watch.expired());
+}
+
+} // namespace
+
+int main() {
+  testDisconnectReleasesSlot();
+  testDisconnectWhileEmitting();
+  testOutlivesSignal();
+  testGroupOrder();
+  testQueued();
+  testConcurrentDisconnect();
+  return check_result();
+}
@@ -0,0 +1,121 @@
+/**
+ * Runs V4L2Source over FileV4L2Device, so the REQBUFS/mmap/QBUF/DQBUF path is
+ * checked without a camera.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "timestamp.h"
+#include "v4l2_source.h"
+
+#include "check.h"
+
+namespace {
+
+const int kWidth = 64;
+const int kHeight = 48;
+const int kFrames = 5;
+const char kPath[] = "v4l2_source_test.yuyv";
+
+/** Frame k is filled with the value k + 1 */
+void writeFrames() {
+  std::ofstream file(kPath, std::ios::binary);
+  for (int k = 0; k < kFrames; ++k) {
+    const std::vector<char> frame(kWidth * kHeight * 2, static_cast<char>(k + 1));
+    file.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+  }
+}
+
+sample::V4L2Options fileOptions(const std::string& path) {
+  sample::V4L2Options options;
+  options.device = "file:" + path;
+  options.width = kWidth;
+  options.height = kHeight;
+  options.format = sample::PixelFormat::kYUYV;
+  options.fps = 200;
+  options.buffer_count = 3;
+  return options;
+}
+
+void testFrames() {
+  sample::V4L2Source source(fileOptions(kPath));
+  CHECK(source.open());
+
+  std::int64_t last_timestamp_us = 0;
+  std::uint64_t last_sequence = 0;
+  int last_value = 0;
+  int changes = 0;
+  for (int i = 0; i < 20; ++i) {
+    const auto frame = source.read();
+    CHECK(!frame.empty());
+    if (frame.empty())
+      continue;
+
+    const auto& mat = frame.mat();
+    CHECK(mat.rows == kHeight && mat.cols == kWidth && mat.type() == CV_8UC2);
+    CHECK(frame.info().size == cv::Size(kWidth, kHeight));
+    CHECK(frame.info().format == sample::PixelFormat::kYUYV);
+    CHECK(frame.info().timestamp_us > last_timestamp_us);
+    CHECK(frame.info().timestamp_us <= sample::steadyMicros());
+    CHECK(i == 0 || frame.info().sequence > last_sequence);
+
+    // Every byte comes from the same file frame
+    const int value = mat.data[0];
+    CHECK(value >= 1 && value <= kFrames);
+    bool uniform = true;
+    for (int y = 0; y < mat.rows; ++y) {
+      const auto* row = mat.ptr<std::uint8_t>(y);
+      for (int x = 0; x < mat.cols * 2; ++x)
+        uniform = uniform && row[x] == value;
+    }
+    CHECK(uniform);
+    if (value != last_value)
+      ++changes;
+
+    last_timestamp_us = frame.info().timestamp_us;
+    last_sequence = frame.info().sequence;
+    last_value = value;
+  }
+  CHECK(changes > 1);
+}
+
+void testStarved() {
+  sample::V4L2Source source(fileOptions(kPath));
+  CHECK(source.open());
+
+  // Holding every buffer leaves the driver nothing to fill
+  std::vector<sample::Frame> held;
+  for (int i = 0; i < 20 && source.starved_count() == 0; ++i) {
+    auto frame = source.read();
+    if (!frame.empty())
+      held.push_back(frame);
+  }
+  CHECK(source.starved_count() > 0);
+  CHECK(held.size() == 3);
+
+  held.clear();
+  sample::Frame frame;
+  for (int i = 0; i < 3 && frame.empty(); ++i)
+    frame = source.read();
+  CHECK(!frame.empty());
+}
+
+void testMissingFile() {
+  sample::V4L2Source source(fileOptions("does-not-exist.yuyv"));
+  CHECK(!source.open());
+}
+
+} // namespace
+
+int main() {
+  writeFrames();
+  testFrames();
+  testStarved();
+  testMissingFile();
+  std::remove(kPath);
+  return check_result();
+}
@@ -0,0 +1,23 @@
+/**
+ * Common timebase of the sample.
+ *
+ * Frame timestamps, SDK timestamps and latency measurements are all microseconds
+ * on std::chrono::steady_clock (CLOCK_MONOTONIC on Linux, the clock V4L2 stamps buffers with).
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_TIMESTAMP_H_
+#define EYEDID_CPP_SAMPLE_TIMESTAMP_H_
+
+#include <chrono>
+#include <cstdint>
+
+namespace sample {
+
+inline std::int64_t steadyMicros() {
+  using clock = std::chrono::steady_clock;
+  return std::chrono::duration_cast<std::chrono::microseconds>(clock::now().time_since_epoch()).count();
+}
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_TIMESTAMP_H_
@@ -1,18 +1,19 @@
 #include "tracker_manager.h"
 
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <thread>
 #include <utility>
 #include <vector>
-#include <deque>
 
 #include "eyedid/util/display.h"
 
-namespace sample {
+#include "timestamp.h"
 
-    static const int FILTER_SIZE = 3;  // 53  ( )
+namespace sample {
 
-    static std::vector<float> getWindowRectWithPadding(const char* window_name, int padding = 30) {
-        const auto window_rect = eyedid::getWindowRect(window_name);
+    static std::vector<float> getWindowRectWithPadding(const eyedid::Rect& window_rect, int padding = 30) {
         return {
           static_cast<float>(window_rect.x + padding),
           static_cast<float>(window_rect.y + padding),
@@ -25,6 +26,8 @@ namespace sample {
         const EyedidFaceData& face_data,
         const EyedidBlinkData& blink_data,
         const EyedidUserStatusData& user_status_data) {
+        latency_.add(steadyMicros() - acquisitionMicros(timestamp));
+
         this->OnGaze(timestamp,
             gaze_data.x,
             gaze_data.y,
@@ -55,6 +58,7 @@ namespace sample {
     }
 
     void TrackerManager::OnDrop(uint64_t timestamp) {
+        admission_.drop();
         std::cout << "Tracker dropped at " << timestamp << '\n';
     }
 
@@ -64,36 +68,25 @@ namespace sample {
         EyedidTrackingState tracking_state,
         EyedidEyeMovementState eye_movement_state) {
         if (tracking_state != kEyedidTrackingSuccess) {
-            gaze_history_.clear();
+            gaze_filter_.reset();
+            predictor_.reset();
             on_gaze_(0, 0, false);
             return;
         }
 
         // Convert the gaze point(in display pixels) to the pixels of the OpenCV window
-        auto winPos = eyedid::getWindowPosition(window_name_);
+        auto winPos = windowPosition();
         x -= static_cast<float>(winPos.x);
         y -= static_cast<float>(winPos.y);
 
-        // ̵   
-        gaze_history_.push_back({ static_cast<int>(x), static_cast<int>(y) });
-        if (gaze_history_.size() > FILTER_SIZE)
-            gaze_history_.pop_front();
-
-        //  
-        int avg_x = 0, avg_y = 0;
-        if (!gaze_history_.empty()) {
-            for (const auto& g : gaze_history_) {
-                avg_x += g.first;
-                avg_y += g.second;
-            }
-            avg_x /= static_cast<int>(gaze_history_.size());
-            avg_y /= static_cast<int>(gaze_history_.size());
-
-            on_gaze_(avg_x, avg_y, true);
-        }
-        else {
-            on_gaze_(static_cast<int>(x), static_cast<int>(y), true);
-        }
+        if (pending_filter_.fetch())
+            gaze_filter_.configure(pending_filter_.front());
+        const auto filtered = gaze_filter_.filter({ x, y }, timestamp);
+
+        // Seen after the time spent so far, plus the time it takes to reach the screen
+        const auto shown_us = steadyMicros() + display_latency_us_.load(std::memory_order_relaxed);
+        const auto predicted = predictor_.predict(filtered, acquisitionMicros(timestamp), eye_movement_state, shown_us);
+        on_gaze_(static_cast<int>(std::lround(predicted.x)), static_cast<int>(std::lround(predicted.y)), true);
     }
 
     void TrackerManager::OnFace(uint64_t timestamp,
@@ -129,7 +122,7 @@ namespace sample {
     }
 
     void TrackerManager::OnCalibrationNextPoint(float next_point_x, float next_point_y) {
-        const auto winPos = eyedid::getWindowPosition(window_name_);
+        const auto winPos = windowPosition();
         const auto x = static_cast<int>(next_point_x - static_cast<float>(winPos.x));
         const auto y = static_cast<int>(next_point_y - static_cast<float>(winPos.y));
         on_calib_next_point_(x, y);
@@ -146,6 +139,12 @@ namespace sample {
     }
 
     bool TrackerManager::initialize(const std::string& license_key, const EyedidTrackerOptions& options) {
+#if defined(EYEDID_SAMPLE_STUB_AUTH_MS)
+        // Built to run without a license: take as long as authentication, and leave the SDK uninitialized
+        std::this_thread::sleep_for(std::chrono::milliseconds(EYEDID_SAMPLE_STUB_AUTH_MS));
+        std::cout << "Authentication stubbed out (" << EYEDID_SAMPLE_STUB_AUTH_MS << " ms). No gaze will be tracked\n";
+        return true;
+#else
         const auto code = gaze_tracker_.initialize(license_key, options);
         if (code != 0) {
             std::cerr << "Failed to authenticate (code: " << code << " )\n";
@@ -159,7 +158,9 @@ namespace sample {
         gaze_tracker_.setTrackingCallback(this);
         gaze_tracker_.setCalibrationCallback(this);
 
+        initialized_ = true;
         return true;
+#endif
     }
 
     void TrackerManager::setDefaultCameraToDisplayConverter(const eyedid::DisplayInfo& display_info) {
@@ -168,11 +169,37 @@ namespace sample {
             display_info.widthMm, display_info.heightMm);
     }
 
-    bool TrackerManager::addFrame(std::int64_t timestamp, const cv::Mat& frame) {
-        return gaze_tracker_.addFrame(timestamp, frame.data, frame.cols, frame.rows);
+    void TrackerManager::setCameraToDisplayConverter(const eyedid::GazeTracker::converter_type& converter) {
+        gaze_tracker_.converter() = converter;
+    }
+
+    void TrackerManager::setTrackingFps(int fps) {
+        if (initialized_)
+            gaze_tracker_.setTrackingFps(fps);
+        admission_.setFps(fps);
+    }
+
+    bool TrackerManager::addFrame(std::int64_t timestamp_us, const cv::Mat& frame) {
+        const auto timestamp_ms = timestamp_us / 1000;
+        acquisition_us_[static_cast<std::size_t>(timestamp_ms) % acquisition_us_.size()]
+            .store(timestamp_us, std::memory_order_relaxed);
+        if (!initialized_)
+            return false;
+        const auto accepted = gaze_tracker_.addFrame(timestamp_ms, frame.data, frame.cols, frame.rows);
+        admission_.report(timestamp_us, accepted);
+        return accepted;
+    }
+
+    std::int64_t TrackerManager::acquisitionMicros(uint64_t timestamp_ms) const {
+        const auto us = acquisition_us_[timestamp_ms % acquisition_us_.size()].load(std::memory_order_relaxed);
+        if (static_cast<uint64_t>(us / 1000) == timestamp_ms)
+            return us;
+        return static_cast<std::int64_t>(timestamp_ms) * 1000;
     }
 
     void TrackerManager::startFullWindowCalibration(EyedidCalibrationPointNum target_num, EyedidCalibrationAccuracy accuracy) {
+        if (!initialized_)
+            return;
         bool expected = false;
         if (!calibrating_.compare_exchange_strong(expected, true))
             return;
@@ -181,15 +208,41 @@ namespace sample {
 
         delayed_calibration_ = std::async(std::launch::async, [=]() {
             std::this_thread::sleep_for(std::chrono::seconds(3));
-            const auto window_rect = getWindowRectWithPadding(window_name_.c_str());
+            const auto window_rect = getWindowRectWithPadding(windowRect());
             gaze_tracker_.startCalibration(target_num, accuracy,
                 window_rect[0], window_rect[1], window_rect[2], window_rect[3]);
             });
     }
 
     void TrackerManager::setWholeScreenToAttentionRegion(const eyedid::DisplayInfo& display_info) {
+        if (!initialized_)
+            return;
         gaze_tracker_.setAttentionRegion(0, 0,
             static_cast<float>(display_info.widthPx), static_cast<float>(display_info.heightPx));
     }
 
+    void TrackerManager::setGazeFilter(const GazeFilter::Params& params) {
+        pending_filter_.back() = params;
+        pending_filter_.publish();
+    }
+
+    void TrackerManager::setWindowGeometry(const WindowGeometry* geometry) {
+        // The delayed calibration reads the window rect on its own thread
+        if (delayed_calibration_.valid())
+            delayed_calibration_.wait();
+        window_geometry_.store(geometry);
+    }
+
+    eyedid::Point<long> TrackerManager::windowPosition() const {
+        if (const auto geometry = window_geometry_.load())
+            return geometry->position();
+        return eyedid::getWindowPosition(window_name_);
+    }
+
+    eyedid::Rect TrackerManager::windowRect() const {
+        if (const auto geometry = window_geometry_.load())
+            return geometry->rect();
+        return eyedid::getWindowRect(window_name_);
+    }
+
 } // namespace sample
@@ -1,19 +1,26 @@
 #ifndef EYEDID_CPP_SAMPLE_TRACKER_MANAGER_H_
 #define EYEDID_CPP_SAMPLE_TRACKER_MANAGER_H_
 
+#include <array>
 #include <atomic>
+#include <cstdint>
 #include <future>
 #include <memory>
 #include <string>
 #include <vector>
-#include <deque>
 
 #include "eyedid/gaze_tracker.h"
 #include "eyedid/util/display.h"
 
 #include "opencv2/opencv.hpp"
 
+#include "frame_admission.h"
+#include "gaze_filter.h"
+#include "gaze_predictor.h"
+#include "latency_stats.h"
 #include "simple_signal.h"
+#include "triple_buffer.h"
+#include "window_geometry.h"
 
 namespace sample {
 
@@ -23,16 +30,72 @@ namespace sample {
     public:
         TrackerManager() = default;
 
+        /**
+         * Authenticate and initialize the SDK.
+         * When built with EYEDID_SAMPLE_STUB_AUTH_MS, sleeps that many milliseconds instead and
+         * succeeds without initializing the SDK; addFrame() then rejects every frame, as if the
+         * SDK had omitted it.
+         */
         bool initialize(const std::string& license_key, const EyedidTrackerOptions& options);
 
         void setDefaultCameraToDisplayConverter(const eyedid::DisplayInfo& display_info);
 
-        bool addFrame(std::int64_t timestamp, const cv::Mat& frame);
+        /** Use when the camera is not at the top-center of the display */
+        void setCameraToDisplayConverter(const eyedid::GazeTracker::converter_type& converter);
+
+        /** Limit the frames the SDK tracks. admitFrame() follows the same limit */
+        void setTrackingFps(int fps);
+
+        /**
+         * Whether a frame with this timestamp is expected to pass the tracking fps limit.
+         * Check before converting a frame for addFrame(); skipped frames would be omitted by the SDK anyway.
+         * Call from the thread that calls addFrame().
+         */
+        bool admitFrame(std::int64_t timestamp_us) { return admission_.admit(timestamp_us); }
+
+        /**
+         * Pass an RGB frame to the SDK.
+         * @param timestamp_us acquisition time of the frame (FrameInfo::timestamp_us)
+         * @return false if the SDK omitted the frame
+         */
+        bool addFrame(std::int64_t timestamp_us, const cv::Mat& frame);
+
+        /** How well admitFrame() predicted the SDK */
+        AdmissionStats admission() const { return admission_.stats(); }
+
+        /** Time from frame acquisition to the gaze result of that frame */
+        LatencyStats::Snapshot latency() const { return latency_.snapshot(); }
 
         void startFullWindowCalibration(EyedidCalibrationPointNum target_num, EyedidCalibrationAccuracy accuracy);
 
         void setWholeScreenToAttentionRegion(const eyedid::DisplayInfo& display_info);
 
+        /**
+         * Smooth gaze points with this filter from the next point on.
+         * May be called while tracking, from one thread at a time.
+         */
+        void setGazeFilter(const GazeFilter::Params& params);
+
+        /**
+         * Extrapolate filtered gaze points to the time they are expected to be seen:
+         * the acquisition time of their frame, plus the pipeline latency measured for each point,
+         * plus setDisplayLatency(). Predictions are checked against later points either way.
+         */
+        void setGazePrediction(bool enabled) { predictor_.setEnabled(enabled); }
+
+        /** Time from on_gaze_ until the point is on screen. May be called while tracking */
+        void setDisplayLatency(std::int64_t us) { display_latency_us_.store(us, std::memory_order_relaxed); }
+
+        GazePredictor::Stats prediction() const { return predictor_.stats(); }
+
+        /**
+         * Map gaze and calibration points to the window cached by `geometry` instead of
+         * querying the window named window_name_ for each point. `geometry` must outlive tracking.
+         * Call before tracking starts, and with nullptr after it stopped, before `geometry` is
+         * destroyed; that waits for a calibration that is still being started.
+         */
+        void setWindowGeometry(const WindowGeometry* geometry);
+
         // message senders
         signal<void(int, int, bool)> on_gaze_;
         signal<void(float)> on_calib_progress_;
@@ -61,12 +124,29 @@ namespace sample {
         void OnCalibrationFinish(const std::vector<float>& calib_data) override;
         void OnCalibrationCancel(const std::vector<float>& calib_data) override;
 
+        eyedid::Point<long> windowPosition() const;
+        eyedid::Rect windowRect() const;
+
         eyedid::GazeTracker gaze_tracker_;
+        // Set by initialize(), before tracking starts
+        bool initialized_ = false;
         std::future<void> delayed_calibration_;
         std::atomic_bool calibrating_{ false };
 
-        std::deque<std::pair<int, int>> gaze_history_;
-        static const int FILTER_SIZE = 5;
+        std::atomic<const WindowGeometry*> window_geometry_{ nullptr };
+
+        // The SDK works in milliseconds. Keep the microsecond acquisition time of recent frames,
+        // indexed by their millisecond timestamp, to measure latency without losing precision.
+        std::int64_t acquisitionMicros(uint64_t timestamp_ms) const;
+        std::array<std::atomic<std::int64_t>, 64> acquisition_us_{};
+        LatencyStats latency_;
+        FrameAdmission admission_;
+
+        // Used on the SDK's callback thread only; new parameters arrive through pending_filter_
+        GazeFilter gaze_filter_;
+        triple_buffer<GazeFilter::Params> pending_filter_;
+        GazePredictor predictor_;
+        std::atomic<std::int64_t> display_latency_us_{ 0 };
 
     };
 
@@ -0,0 +1,65 @@
+/**
+ * Wait-free single-producer/single-consumer handoff of the latest value.
+ *
+ * The writer fills back() and publishes it; the reader fetches the newest published
+ * value into front(). Three buffers rotate through one atomic index, so neither side
+ * ever waits for the other and the reader always sees a complete value.
+ * Intermediate values published between two fetches are skipped.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_TRIPLE_BUFFER_H_
+#define EYEDID_CPP_SAMPLE_TRIPLE_BUFFER_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace sample {
+
+template<typename T>
+class triple_buffer {
+ public:
+  triple_buffer() = default;
+
+  triple_buffer(const triple_buffer&) = delete;
+  triple_buffer& operator=(const triple_buffer&) = delete;
+
+  /**
+   * Writer: the buffer to fill. It holds an older value, so overwrite it completely.
+   */
+  T& back() { return buffers_[back_]; }
+
+  /** Writer: make back() the newest value and take another buffer as back() */
+  void publish() {
+    const auto prev = middle_.exchange(static_cast<std::uint8_t>(back_ | kFresh), std::memory_order_acq_rel);
+    back_ = static_cast<std::uint8_t>(prev & kIndex);
+  }
+
+  /**
+   * Reader: move the newest published value to front().
+   * @return false if nothing was published since the last fetch
+   */
+  bool fetch() {
+    if (!(middle_.load(std::memory_order_acquire) & kFresh))
+      return false;
+    const auto prev = middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = static_cast<std::uint8_t>(prev & kIndex);
+    return true;
+  }
+
+  /** Reader: the value of the last fetch. Stays valid until the next fetch */
+  T& front() { return buffers_[front_]; }
+  const T& front() const { return buffers_[front_]; }
+
+ private:
+  enum : std::uint8_t { kIndex = 0x3, kFresh = 0x4 };
+
+  T buffers_[3];
+  // Index of the buffer between writer and reader, plus kFresh if it was published but not fetched
+  std::atomic<std::uint8_t> middle_{1};
+  std::uint8_t back_ = 0;   // writer only
+  std::uint8_t front_ = 2;  // reader only
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_TRIPLE_BUFFER_H_
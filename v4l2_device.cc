@@ -0,0 +1,294 @@
+#include "v4l2_device.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <linux/videodev2.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+#include "timestamp.h"
+
+namespace sample {
+
+/** V4L2Device::system */
+namespace {
+
+class SystemV4L2Device : public V4L2Device {
+ public:
+  int open(const char* path, int flags) override { return ::open(path, flags); }
+  int close(int fd) override { return ::close(fd); }
+  int ioctl(int fd, unsigned long request, void* arg) override { return ::ioctl(fd, request, arg); }
+  int poll(pollfd* fds, nfds_t count, int timeout_ms) override { return ::poll(fds, count, timeout_ms); }
+  void* mmap(std::size_t length, int fd, off_t offset) override {
+    return ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+  }
+  int munmap(void* address, std::size_t length) override { return ::munmap(address, length); }
+};
+
+} // namespace
+
+V4L2Device& V4L2Device::system() {
+  static SystemV4L2Device device;
+  return device;
+}
+
+/** FileV4L2Device */
+constexpr int FileV4L2Device::kFd;
+
+// Buffer offsets handed out by QUERYBUF; only mmap() interprets them
+static constexpr off_t kOffsetStep = 1 << 24;
+static constexpr std::uint32_t kMaxBuffers = 32;
+
+static int fail(int error) {
+  errno = error;
+  return -1;
+}
+
+FileV4L2Device::FileV4L2Device(std::string path) : path_(std::move(path)) {}
+
+int FileV4L2Device::open(const char*, int) {
+  std::lock_guard<std::mutex> lck(mutex_);
+  if (open_)
+    return fail(EBUSY);
+  file_.open(path_, std::ios::binary);
+  if (!file_)
+    return fail(ENOENT);
+  open_ = true;
+  return kFd;
+}
+
+int FileV4L2Device::close(int fd) {
+  std::lock_guard<std::mutex> lck(mutex_);
+  if (!open_ || fd != kFd)
+    return fail(EBADF);
+  streaming_ = false;
+  queued_.clear();
+  filled_.clear();
+  buffers_.clear();
+  file_.close();
+  open_ = false;
+  return 0;
+}
+
+int FileV4L2Device::ioctl(int fd, unsigned long request, void* arg) {
+  std::lock_guard<std::mutex> lck(mutex_);
+  if (!open_ || fd != kFd)
+    return fail(EBADF);
+
+  switch (request) {
+    case VIDIOC_QUERYCAP: {
+      auto* cap = static_cast<v4l2_capability*>(arg);
+      std::memset(cap, 0, sizeof(*cap));
+      std::strncpy(reinterpret_cast<char*>(cap->driver), "file", sizeof(cap->driver) - 1);
+      std::strncpy(reinterpret_cast<char*>(cap->card), path_.c_str(), sizeof(cap->card) - 1);
+      cap->device_caps = V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_STREAMING;
+      cap->capabilities = cap->device_caps | V4L2_CAP_DEVICE_CAPS;
+      return 0;
+    }
+    case VIDIOC_S_FMT:
+      return setFormat(arg);
+    case VIDIOC_S_PARM: {
+      auto* parm = static_cast<v4l2_streamparm*>(arg);
+      const auto& frame_time = parm->parm.capture.timeperframe;
+      if (frame_time.numerator > 0 && frame_time.denominator > 0)
+        interval_us_ = static_cast<std::int64_t>(frame_time.numerator) * 1000000 / frame_time.denominator;
+      return 0;
+    }
+    case VIDIOC_REQBUFS:
+      return requestBuffers(arg);
+    case VIDIOC_QUERYBUF:
+      return queryBuffer(arg);
+    case VIDIOC_QBUF:
+      return queueBuffer(arg);
+    case VIDIOC_DQBUF:
+      return dequeueBuffer(arg);
+    case VIDIOC_STREAMON:
+      if (buffers_.empty())
+        return fail(EINVAL);
+      streaming_ = true;
+      next_frame_us_ = steadyMicros();
+      return 0;
+    case VIDIOC_STREAMOFF:
+      streaming_ = false;
+      queued_.clear();
+      filled_.clear();
+      return 0;
+    default:
+      return fail(ENOTTY);
+  }
+}
+
+int FileV4L2Device::setFormat(void* arg) {
+  auto& pix = static_cast<v4l2_format*>(arg)->fmt.pix;
+  if (streaming_ || !buffers_.empty())
+    return fail(EBUSY);
+  if (pix.width == 0 || pix.height == 0)
+    return fail(EINVAL);
+
+  // Like a driver, answer an unsupported format with a supported one
+  if (pix.pixelformat != V4L2_PIX_FMT_YUYV && pix.pixelformat != V4L2_PIX_FMT_NV12)
+    pix.pixelformat = V4L2_PIX_FMT_YUYV;
+  pix.field = V4L2_FIELD_NONE;
+  if (pix.pixelformat == V4L2_PIX_FMT_YUYV) {
+    pix.bytesperline = pix.width * 2;
+    pix.sizeimage = pix.bytesperline * pix.height;
+  }
+  else {
+    pix.bytesperline = pix.width;
+    pix.sizeimage = pix.width * pix.height * 3 / 2;
+  }
+
+  // The file must hold at least one frame of this geometry
+  file_.clear();
+  file_.seekg(0, std::ios::end);
+  const auto file_bytes = static_cast<std::size_t>(file_.tellg());
+  file_.seekg(0);
+  if (file_bytes < pix.sizeimage)
+    return fail(EINVAL);
+
+  fourcc_ = pix.pixelformat;
+  width_ = pix.width;
+  height_ = pix.height;
+  bytes_per_line_ = pix.bytesperline;
+  frame_bytes_ = pix.sizeimage;
+  return 0;
+}
+
+int FileV4L2Device::requestBuffers(void* arg) {
+  auto* req = static_cast<v4l2_requestbuffers*>(arg);
+  if (req->type != V4L2_BUF_TYPE_VIDEO_CAPTURE || req->memory != V4L2_MEMORY_MMAP)
+    return fail(EINVAL);
+  if (streaming_)
+    return fail(EBUSY);
+
+  queued_.clear();
+  filled_.clear();
+  buffers_.clear();
+  if (req->count == 0)
+    return 0;
+  if (frame_bytes_ == 0)
+    return fail(EINVAL);
+
+  req->count = std::min(req->count, kMaxBuffers);
+  buffers_.assign(req->count, std::vector<std::uint8_t>(frame_bytes_));
+  return 0;
+}
+
+int FileV4L2Device::queryBuffer(void* arg) {
+  auto* buf = static_cast<v4l2_buffer*>(arg);
+  if (buf->index >= buffers_.size())
+    return fail(EINVAL);
+  buf->length = static_cast<std::uint32_t>(frame_bytes_);
+  buf->m.offset = static_cast<std::uint32_t>(buf->index * kOffsetStep);
+  return 0;
+}
+
+int FileV4L2Device::queueBuffer(void* arg) {
+  const auto* buf = static_cast<const v4l2_buffer*>(arg);
+  if (buf->index >= buffers_.size())
+    return fail(EINVAL);
+  queued_.push_back(buf->index);
+  return 0;
+}
+
+int FileV4L2Device::dequeueBuffer(void* arg) {
+  produce(steadyMicros());
+  if (filled_.empty())
+    return fail(EAGAIN);
+
+  const auto filled = filled_.front();
+  filled_.pop_front();
+  auto* buf = static_cast<v4l2_buffer*>(arg);
+  buf->index = filled.index;
+  buf->bytesused = static_cast<std::uint32_t>(frame_bytes_);
+  buf->flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+  buf->field = V4L2_FIELD_NONE;
+  buf->sequence = filled.sequence;
+  buf->timestamp.tv_sec = static_cast<time_t>(filled.timestamp_us / 1000000);
+  buf->timestamp.tv_usec = static_cast<suseconds_t>(filled.timestamp_us % 1000000);
+  return 0;
+}
+
+int FileV4L2Device::poll(pollfd* fds, nfds_t count, int timeout_ms) {
+  if (count != 1 || fds[0].fd != kFd)
+    return fail(EINVAL);
+
+  const auto deadline_us = steadyMicros() + static_cast<std::int64_t>(timeout_ms) * 1000;
+  while (true) {
+    std::int64_t wait_us;
+    {
+      std::lock_guard<std::mutex> lck(mutex_);
+      const auto now_us = steadyMicros();
+      produce(now_us);
+      fds[0].revents = 0;
+      if (!filled_.empty()) {
+        fds[0].revents = POLLIN;
+        return 1;
+      }
+      // A driver with no buffer to fill reports an error, as V4L2Source expects
+      if (streaming_ && queued_.empty()) {
+        fds[0].revents = POLLERR;
+        return 1;
+      }
+      if (now_us >= deadline_us)
+        return 0;
+      wait_us = std::min(next_frame_us_, deadline_us) - now_us;
+      if (!streaming_)
+        wait_us = deadline_us - now_us;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(std::max<std::int64_t>(wait_us, 100)));
+  }
+}
+
+void FileV4L2Device::produce(std::int64_t now_us) {
+  if (!streaming_)
+    return;
+  while (next_frame_us_ <= now_us) {
+    // Without a queued buffer the frame is lost, as with a real camera
+    if (!queued_.empty()) {
+      const auto index = queued_.front();
+      queued_.pop_front();
+      readFrame(&buffers_[index]);
+      filled_.push_back({ index, sequence_, next_frame_us_ });
+    }
+    ++sequence_;
+    next_frame_us_ += interval_us_;
+  }
+}
+
+bool FileV4L2Device::readFrame(std::vector<std::uint8_t>* buffer) {
+  const auto size = static_cast<std::streamsize>(frame_bytes_);
+  file_.read(reinterpret_cast<char*>(buffer->data()), size);
+  if (file_.gcount() == size)
+    return true;
+
+  // Loop; a trailing partial frame is skipped
+  file_.clear();
+  file_.seekg(0);
+  file_.read(reinterpret_cast<char*>(buffer->data()), size);
+  return file_.gcount() == size;
+}
+
+void* FileV4L2Device::mmap(std::size_t length, int fd, off_t offset) {
+  std::lock_guard<std::mutex> lck(mutex_);
+  const auto index = static_cast<std::size_t>(offset / kOffsetStep);
+  if (fd != kFd || offset % kOffsetStep != 0 || index >= buffers_.size() || length > buffers_[index].size()) {
+    errno = EINVAL;
+    return MAP_FAILED;
+  }
+  return buffers_[index].data();
+}
+
+int FileV4L2Device::munmap(void*, std::size_t) {
+  return 0;
+}
+
+} // namespace sample
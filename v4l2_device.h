@@ -0,0 +1,102 @@
+/**
+ * The system calls V4L2Source makes, so that it can capture from something other than
+ * a kernel driver.
+ *
+ * FileV4L2Device plays a capture device whose frames come from a file of raw frames.
+ * It follows the driver's buffer protocol (REQBUFS, QUERYBUF, mmap, QBUF, poll, DQBUF)
+ * closely enough to exercise V4L2Source without a camera or the vivid module.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_V4L2_DEVICE_H_
+#define EYEDID_CPP_SAMPLE_V4L2_DEVICE_H_
+
+#include <poll.h>
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sample {
+
+class V4L2Device {
+ public:
+  virtual ~V4L2Device() = default;
+
+  // Same contracts as the system calls: -1 and errno on failure
+  virtual int open(const char* path, int flags) = 0;
+  virtual int close(int fd) = 0;
+  virtual int ioctl(int fd, unsigned long request, void* arg) = 0;
+  virtual int poll(pollfd* fds, nfds_t count, int timeout_ms) = 0;
+  /** MAP_FAILED on failure */
+  virtual void* mmap(std::size_t length, int fd, off_t offset) = 0;
+  virtual int munmap(void* address, std::size_t length) = 0;
+
+  /** The kernel */
+  static V4L2Device& system();
+};
+
+/**
+ * A capture device that plays a file of concatenated raw YUYV or NV12 frames, in a loop.
+ *
+ * The frame geometry is whatever VIDIOC_S_FMT asks for. Frames are produced at the rate
+ * set with VIDIOC_S_PARM (30 fps by default), stamped with the monotonic clock like a
+ * real driver. Safe to use from several threads, as V4L2Source recycles buffers on
+ * whichever thread releases the last Frame.
+ */
+class FileV4L2Device : public V4L2Device {
+ public:
+  explicit FileV4L2Device(std::string path);
+
+  int open(const char* path, int flags) override;
+  int close(int fd) override;
+  int ioctl(int fd, unsigned long request, void* arg) override;
+  int poll(pollfd* fds, nfds_t count, int timeout_ms) override;
+  void* mmap(std::size_t length, int fd, off_t offset) override;
+  int munmap(void* address, std::size_t length) override;
+
+ private:
+  static constexpr int kFd = 1000;
+
+  int setFormat(void* arg);
+  int requestBuffers(void* arg);
+  int queryBuffer(void* arg);
+  int queueBuffer(void* arg);
+  int dequeueBuffer(void* arg);
+
+  /** Fill queued buffers with the frames that are due by now */
+  void produce(std::int64_t now_us);
+  bool readFrame(std::vector<std::uint8_t>* buffer);
+
+  std::string path_;
+  std::mutex mutex_;
+  bool open_ = false;
+  std::ifstream file_;
+
+  std::uint32_t fourcc_ = 0;
+  std::uint32_t width_ = 0;
+  std::uint32_t height_ = 0;
+  std::uint32_t bytes_per_line_ = 0;
+  std::size_t frame_bytes_ = 0;
+  std::int64_t interval_us_ = 1000000 / 30;
+
+  std::vector<std::vector<std::uint8_t>> buffers_;
+  std::deque<std::uint32_t> queued_;
+  struct Filled {
+    std::uint32_t index;
+    std::uint32_t sequence;
+    std::int64_t timestamp_us;
+  };
+  std::deque<Filled> filled_;
+  bool streaming_ = false;
+  std::int64_t next_frame_us_ = 0;
+  std::uint32_t sequence_ = 0;
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_V4L2_DEVICE_H_
@@ -0,0 +1,288 @@
+#include "v4l2_source.h"
+
+#include "timestamp.h"
+#include "v4l2_device.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+
+#include <linux/videodev2.h>
+
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+namespace sample {
+
+static std::uint32_t toFourcc(PixelFormat format) {
+  switch (format) {
+    case PixelFormat::kYUYV: return V4L2_PIX_FMT_YUYV;
+    case PixelFormat::kNV12: return V4L2_PIX_FMT_NV12;
+    case PixelFormat::kMJPEG: return V4L2_PIX_FMT_MJPEG;
+    default: return 0;
+  }
+}
+
+static const char kFilePrefix[] = "file:";
+
+V4L2Source::V4L2Source(V4L2Options options)
+  : FrameStore(VIDEO_MAX_FRAME), options_(std::move(options)), device_(&V4L2Device::system()) {
+  if (options_.device.compare(0, sizeof(kFilePrefix) - 1, kFilePrefix) == 0) {
+    owned_device_.reset(new FileV4L2Device(options_.device.substr(sizeof(kFilePrefix) - 1)));
+    device_ = owned_device_.get();
+  }
+}
+
+V4L2Source::~V4L2Source() {
+  close();
+}
+
+int V4L2Source::xioctl(unsigned long request, void* arg) {
+  int r;
+  do {
+    r = device_->ioctl(fd_, request, arg);
+  } while (r == -1 && errno == EINTR);
+  return r;
+}
+
+bool V4L2Source::open() {
+  close();
+
+  fourcc_ = toFourcc(options_.format);
+  if (fourcc_ == 0) {
+    std::cerr << "V4L2: unsupported pixel format\n";
+    return false;
+  }
+
+  fd_ = device_->open(options_.device.c_str(), O_RDWR | O_NONBLOCK);
+  if (fd_ == -1) {
+    std::cerr << "V4L2: failed to open " << options_.device << ": " << std::strerror(errno) << '\n';
+    return false;
+  }
+
+  v4l2_capability cap{};
+  if (xioctl(VIDIOC_QUERYCAP, &cap) == -1) {
+    std::cerr << "V4L2: " << options_.device << " is not a V4L2 device\n";
+    close();
+    return false;
+  }
+  const auto caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+  if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) {
+    std::cerr << "V4L2: " << options_.device << " does not support streaming capture\n";
+    close();
+    return false;
+  }
+
+  v4l2_format fmt{};
+  fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  fmt.fmt.pix.width = static_cast<std::uint32_t>(options_.width);
+  fmt.fmt.pix.height = static_cast<std::uint32_t>(options_.height);
+  fmt.fmt.pix.pixelformat = fourcc_;
+  fmt.fmt.pix.field = V4L2_FIELD_NONE;
+  if (xioctl(VIDIOC_S_FMT, &fmt) == -1 || fmt.fmt.pix.pixelformat != fourcc_) {
+    std::cerr << "V4L2: the requested pixel format is not supported by " << options_.device << '\n';
+    close();
+    return false;
+  }
+  width_ = static_cast<int>(fmt.fmt.pix.width);
+  height_ = static_cast<int>(fmt.fmt.pix.height);
+  bytes_per_line_ = fmt.fmt.pix.bytesperline;
+
+  if (options_.fps > 0) {
+    v4l2_streamparm parm{};
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    parm.parm.capture.timeperframe.numerator = 1;
+    parm.parm.capture.timeperframe.denominator = static_cast<std::uint32_t>(options_.fps);
+    xioctl(VIDIOC_S_PARM, &parm); // best effort
+  }
+
+  if (!start_streaming()) {
+    close();
+    return false;
+  }
+
+  // Same check as the OpenCV backend: make sure that a frame actually arrives
+  Frame probe;
+  for (int i = 0; i < 3 && probe.empty(); ++i)
+    probe = read();
+  if (probe.empty()) {
+    std::cerr << "Camera is opened, but failed to get a frame. Try changing the device\n";
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+bool V4L2Source::start_streaming() {
+  v4l2_requestbuffers req{};
+  req.count = static_cast<std::uint32_t>(options_.buffer_count);
+  req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  req.memory = V4L2_MEMORY_MMAP;
+  if (xioctl(VIDIOC_REQBUFS, &req) == -1 || req.count < 2) {
+    std::cerr << "V4L2: failed to request mmap buffers\n";
+    return false;
+  }
+  if (req.count > capacity())
+    req.count = static_cast<std::uint32_t>(capacity());
+
+  buffers_.assign(req.count, Buffer());
+  bytes_used_.assign(req.count, 0);
+  timestamps_us_.assign(req.count, 0);
+  for (std::uint32_t i = 0; i < req.count; ++i) {
+    v4l2_buffer buf{};
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = i;
+    if (xioctl(VIDIOC_QUERYBUF, &buf) == -1) {
+      std::cerr << "V4L2: VIDIOC_QUERYBUF failed\n";
+      return false;
+    }
+
+    void* start = device_->mmap(buf.length, fd_, buf.m.offset);
+    if (start == MAP_FAILED) {
+      std::cerr << "V4L2: mmap failed: " << std::strerror(errno) << '\n';
+      return false;
+    }
+    buffers_[i].start = start;
+    buffers_[i].length = buf.length;
+  }
+
+  streaming_ = true;
+  for (std::uint32_t i = 0; i < buffers_.size(); ++i) {
+    if (!enqueue(i)) {
+      std::cerr << "V4L2: VIDIOC_QBUF failed\n";
+      return false;
+    }
+  }
+
+  v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  if (xioctl(VIDIOC_STREAMON, &type) == -1) {
+    std::cerr << "V4L2: VIDIOC_STREAMON failed\n";
+    return false;
+  }
+  return true;
+}
+
+void V4L2Source::close() {
+  if (fd_ == -1)
+    return;
+
+  if (streaming_.exchange(false)) {
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    xioctl(VIDIOC_STREAMOFF, &type);
+  }
+
+  for (auto& buffer : buffers_) {
+    if (buffer.start)
+      device_->munmap(buffer.start, buffer.length);
+  }
+  buffers_.clear();
+
+  v4l2_requestbuffers req{};
+  req.count = 0;
+  req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  req.memory = V4L2_MEMORY_MMAP;
+  xioctl(VIDIOC_REQBUFS, &req);
+
+  device_->close(fd_);
+  fd_ = -1;
+}
+
+Frame V4L2Source::read() {
+  pollfd pfd{};
+  pfd.fd = fd_;
+  pfd.events = POLLIN;
+  const int r = device_->poll(&pfd, 1, 1000);
+  if (r <= 0)
+    return Frame();
+
+  if (pfd.revents & POLLERR) {
+    // No buffer is queued: listeners are holding all of them
+    count_starved();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return Frame();
+  }
+
+  int index = dequeue();
+  if (index < 0)
+    return Frame();
+
+  // Deliver only the newest of the filled buffers
+  int newer;
+  while ((newer = dequeue()) >= 0) {
+    enqueue(static_cast<std::uint32_t>(index));
+    skipped_.fetch_add(1, std::memory_order_relaxed);
+    index = newer;
+  }
+
+  return wrap(static_cast<std::uint32_t>(index));
+}
+
+int V4L2Source::dequeue() {
+  v4l2_buffer buf{};
+  buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  buf.memory = V4L2_MEMORY_MMAP;
+  if (xioctl(VIDIOC_DQBUF, &buf) == -1)
+    return -1;
+
+  if (buf.flags & V4L2_BUF_FLAG_ERROR) {
+    enqueue(buf.index);
+    return -1;
+  }
+
+  bytes_used_[buf.index] = buf.bytesused;
+
+  // The driver stamps the buffer when its first byte was captured. Only a monotonic stamp
+  // shares the steady clock's timebase; otherwise fall back to the dequeue time.
+  if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+    timestamps_us_[buf.index] =
+      static_cast<std::int64_t>(buf.timestamp.tv_sec) * 1000000 + static_cast<std::int64_t>(buf.timestamp.tv_usec);
+  } else {
+    timestamps_us_[buf.index] = steadyMicros();
+  }
+
+  return static_cast<int>(buf.index);
+}
+
+bool V4L2Source::enqueue(std::uint32_t index) {
+  v4l2_buffer buf{};
+  buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  buf.memory = V4L2_MEMORY_MMAP;
+  buf.index = index;
+  return xioctl(VIDIOC_QBUF, &buf) != -1;
+}
+
+Frame V4L2Source::wrap(std::uint32_t index) {
+  auto& s = slot(index);
+  auto* data = buffers_[index].start;
+  const auto bytes_used = bytes_used_[index];
+
+  switch (options_.format) {
+    case PixelFormat::kYUYV:
+      s.mat = cv::Mat(height_, width_, CV_8UC2, data, bytes_per_line_);
+      break;
+    case PixelFormat::kNV12:
+      s.mat = cv::Mat(height_ * 3 / 2, width_, CV_8UC1, data, bytes_per_line_);
+      break;
+    default:
+      s.mat = cv::Mat(1, static_cast<int>(bytes_used), CV_8UC1, data);
+      break;
+  }
+
+  s.info.sequence = sequence_++;
+  s.info.timestamp_us = timestamps_us_[index];
+  s.info.format = options_.format;
+  s.info.size = cv::Size(width_, height_);
+  return share(index);
+}
+
+void V4L2Source::recycle(std::uint32_t index) {
+  if (streaming_.load(std::memory_order_acquire))
+    enqueue(index);
+}
+
+} // namespace sample
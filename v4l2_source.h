@@ -0,0 +1,88 @@
+/**
+ * Linux capture backend that talks to V4L2 directly.
+ *
+ * Driver buffers are mmap'd and handed out as zero-copy Frames in the camera's
+ * native pixel format. A buffer is queued back to the driver (QBUF) when its last
+ * Frame handle is released.
+ *
+ * Works with any V4L2 capture device, including the kernel's vivid test driver.
+ * A device path of the form "file:PATH" plays raw frames from PATH through
+ * FileV4L2Device instead, which exercises the same buffer protocol without a driver.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_V4L2_SOURCE_H_
+#define EYEDID_CPP_SAMPLE_V4L2_SOURCE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "frame_pool.h"
+#include "frame_source.h"
+
+namespace sample {
+
+class V4L2Device;
+
+struct V4L2Options {
+  /** A device node, or "file:PATH" for a file of raw frames */
+  std::string device = "/dev/video0";
+  int width = 1280;
+  int height = 720;
+  /** kYUYV, kNV12 or kMJPEG */
+  PixelFormat format = PixelFormat::kYUYV;
+  /** 0 keeps the driver default */
+  int fps = 30;
+  /** Number of driver buffers. The driver may adjust it */
+  std::size_t buffer_count = 4;
+};
+
+class V4L2Source : public FrameSource, public FrameStore {
+ public:
+  explicit V4L2Source(V4L2Options options);
+  ~V4L2Source() override;
+
+  bool open() override;
+  void close() override;
+  Frame read() override;
+
+  /** Frames that were overwritten by a newer one before they were read */
+  std::uint64_t skipped_count() const { return skipped_.load(std::memory_order_relaxed); }
+
+ protected:
+  void recycle(std::uint32_t index) override;
+
+ private:
+  struct Buffer {
+    void* start = nullptr;
+    std::size_t length = 0;
+  };
+
+  bool start_streaming();
+  int dequeue();
+  bool enqueue(std::uint32_t index);
+  Frame wrap(std::uint32_t index);
+  int xioctl(unsigned long request, void* arg);
+
+  V4L2Options options_;
+  std::unique_ptr<V4L2Device> owned_device_;
+  V4L2Device* device_;
+  int fd_ = -1;
+  std::uint32_t fourcc_ = 0;
+  int width_ = 0;
+  int height_ = 0;
+  std::size_t bytes_per_line_ = 0;
+  std::vector<Buffer> buffers_;
+  std::vector<std::size_t> bytes_used_;
+  std::vector<std::int64_t> timestamps_us_;
+  std::atomic_bool streaming_{false};
+  std::uint64_t sequence_ = 0;
+  std::atomic<std::uint64_t> skipped_{0};
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_V4L2_SOURCE_H_
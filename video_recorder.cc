@@ -0,0 +1,107 @@
+#include "video_recorder.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace sample {
+
+VideoRecorder::VideoRecorder(std::size_t buffers) : pool_(buffers) {}
+
+VideoRecorder::~VideoRecorder() {
+  close();
+}
+
+bool VideoRecorder::open(const std::string& path, double fps, cv::Size size, Codec codec) {
+  close();
+
+  // A fourcc of 0 selects uncompressed frames in the AVI container
+  const int fourcc = codec == Codec::kMJPEG ? cv::VideoWriter::fourcc('M', 'J', 'P', 'G') : 0;
+  if (!writer_.open(path, fourcc, fps, size, true) || !writer_.isOpened()) {
+    std::cerr << "Cannot open " << path << " for recording\n";
+    return false;
+  }
+
+  fps_ = fps;
+  size_ = size;
+  pool_.reserve(size.height, size.width, CV_8UC3);
+  last_.release();
+  encoder_.reset(new FrameConsumer([this](const Frame& frame) {
+    encode(frame);
+  }, FramePolicy::kDropOldest));
+  return true;
+}
+
+void VideoRecorder::write(const cv::Mat& image, std::int64_t timestamp_us) {
+  if (!encoder_)
+    return;
+  submitted_.fetch_add(1, std::memory_order_relaxed);
+
+  auto frame = pool_.acquire();
+  if (frame.empty()) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  image.copyTo(pool_.buffer(frame));
+  auto& info = pool_.info(frame);
+  info.timestamp_us = timestamp_us;
+  info.size = image.size();
+  encoder_->push(frame);
+}
+
+void VideoRecorder::encode(const Frame& frame) {
+  if (last_.empty())
+    start_us_ = frame.info().timestamp_us;
+
+  // The pending image covers every frame of the timeline until the next image starts
+  const auto slot = [this](const Frame& f) {
+    return static_cast<std::uint64_t>(static_cast<double>(f.info().timestamp_us - start_us_) * fps_ / 1000000.0);
+  };
+  if (!last_.empty()) {
+    const auto next = slot(frame);
+    if (next <= slot(last_)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+      for (auto n = written_.load(std::memory_order_relaxed); n < next; ++n) {
+        writer_.write(last_.mat());
+        written_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+  last_ = frame;
+}
+
+void VideoRecorder::close() {
+  if (!encoder_)
+    return;
+
+  // Let the encoder catch up before stopping it; anything still queued after that is dropped
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (std::chrono::steady_clock::now() < deadline) {
+    const auto s = encoder_->stats();
+    if (s.processed + s.dropped >= s.received)
+      break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  encoder_->join();
+  dropped_.fetch_add(encoder_->stats().dropped, std::memory_order_relaxed);
+  encoder_.reset();
+
+  if (!last_.empty()) {
+    writer_.write(last_.mat());
+    written_.fetch_add(1, std::memory_order_relaxed);
+    last_.release();
+  }
+  writer_.release();
+}
+
+VideoRecorder::Stats VideoRecorder::stats() const {
+  Stats stats;
+  stats.submitted = submitted_.load(std::memory_order_relaxed);
+  stats.written = written_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+} // namespace sample
@@ -0,0 +1,92 @@
+/**
+ * Encodes composed view images to a video file on a background thread.
+ *
+ * write() copies the image into a recycled buffer and returns; encoding and file I/O
+ * happen on the recorder's FrameConsumer thread. Images are placed on a constant frame
+ * rate timeline by their timestamp: gaps between updates repeat the previous image,
+ * and images arriving faster than the frame rate replace each other.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_VIDEO_RECORDER_H_
+#define EYEDID_CPP_SAMPLE_VIDEO_RECORDER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "opencv2/opencv.hpp"
+
+#include "frame_consumer.h"
+#include "frame_pool.h"
+
+namespace sample {
+
+class VideoRecorder {
+ public:
+  enum class Codec {
+    /** Motion JPEG, fourcc MJPG */
+    kMJPEG,
+    /** Uncompressed BGR */
+    kRaw,
+  };
+
+  struct Stats {
+    /** write() calls */
+    std::uint64_t submitted = 0;
+    /** Frames in the file, including repeats */
+    std::uint64_t written = 0;
+    /** Images not encoded because the encoder fell behind or a newer image replaced them */
+    std::uint64_t dropped = 0;
+  };
+
+  /** @param buffers  number of image buffers shared with the encoder thread */
+  explicit VideoRecorder(std::size_t buffers = 6);
+  ~VideoRecorder();
+
+  VideoRecorder(const VideoRecorder&) = delete;
+  VideoRecorder& operator=(const VideoRecorder&) = delete;
+
+  /**
+   * Create the file and start the encoder thread.
+   * @param size  size of every image passed to write(), CV_8UC3
+   */
+  bool open(const std::string& path, double fps, cv::Size size, Codec codec = Codec::kMJPEG);
+
+  /**
+   * Queue a copy of `image`. Never blocks: the image is dropped if every buffer is in use.
+   * Call from one thread only.
+   * @param timestamp_us  steady clock time the image was shown at
+   */
+  void write(const cv::Mat& image, std::int64_t timestamp_us);
+
+  /** Encode what is still queued and close the file */
+  void close();
+
+  bool isOpen() const { return encoder_ != nullptr; }
+
+  Stats stats() const;
+
+ private:
+  void encode(const Frame& frame);
+
+  FramePool pool_;
+  cv::VideoWriter writer_;
+  double fps_ = 30;
+  cv::Size size_;
+
+  std::atomic<std::uint64_t> submitted_{0};
+  std::atomic<std::uint64_t> written_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+
+  // Encoder thread only
+  Frame last_;
+  std::int64_t start_us_ = 0;
+
+  std::unique_ptr<FrameConsumer> encoder_;
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_VIDEO_RECORDER_H_
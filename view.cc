@@ -1,34 +1,203 @@
 #include "view.h"
 
-#include <cstring> // for memset
-
 #include <algorithm>
+#include <cmath>
+#include <iostream>
 #include <utility>
 
+#include "timestamp.h"
+
 namespace sample {
 
-    View::View(int width, int height, std::string windowName)
-        : background_(height, width, CV_8UC3, { 0, 0, 0 }), window_name_(std::move(windowName)) {
-        cv::namedWindow(window_name_);
+    constexpr int View::kSubpixelShift;
+
+    View::View(int width, int height, std::string windowName, double render_scale, bool headless)
+        : window_name_(std::move(windowName)), render_scale_(render_scale), headless_(headless),
+          window_size_(width, height) {
+        background_ = cv::Mat(toRender(height), toRender(width), CV_8UC3, cv::Scalar(0, 0, 0));
+        if (!headless_)
+            cv::namedWindow(window_name_);
         initElements();
     }
 
-    void View::setPoint(int x, int y) {
-        gaze_point_.center = { x, y };
+    void View::setGaze(int x, int y, bool valid) {
+        const auto now_us = steadyMicros();
+        auto& gaze = gaze_.back();
+        gaze.point = toRender(x, y);
+        gaze.subpixel = toRenderSubpixel(x, y);
+        gaze.valid = valid;
+        gaze.published_us = now_us;
+        gaze_.publish();
+        if (valid) {
+            HeatSample sample;
+            sample.point = gaze.point;
+            sample.timestamp_us = now_us;
+            // A full queue means draw() stalled; the heatmap then only misses a few samples
+            heat_samples_.try_push(sample);
+        }
+        scheduler_.notify();
+    }
+
+    void View::startCalibration() {
+        CalibrationEvent event;
+        event.type = CalibrationEvent::kStart;
+        postCalibrationEvent(event);
+    }
+
+    void View::showCalibrationPoint(int x, int y) {
+        CalibrationEvent event;
+        event.type = CalibrationEvent::kPoint;
+        event.point = toRenderSubpixel(x, y);
+        postCalibrationEvent(event);
+    }
+
+    void View::finishCalibration() {
+        CalibrationEvent event;
+        event.type = CalibrationEvent::kFinish;
+        postCalibrationEvent(event);
+    }
+
+    void View::postCalibrationEvent(const CalibrationEvent& event) {
+        // Calibration events are seconds apart, so the queue only fills up if draw() stopped
+        if (!calibration_events_.try_push(event))
+            std::cerr << "View: calibration event dropped\n";
+        scheduler_.notify();
+    }
+
+    void View::applyUpdates() {
+        if (preview_.fetch()) {
+            auto& frame = scene_[frame_];
+            frame.buffer = preview_.front();
+            frame.invalidate();
+        }
+
+        if (gaze_.fetch()) {
+            const auto& gaze = gaze_.front();
+            auto& gaze_point = scene_[gaze_point_];
+            // Red means the Eyedid cannot inference the gaze point
+            if (gaze.valid) {
+                drawn_gaze_us_ = gaze.published_us;
+                gaze_point.center = gaze.subpixel;
+                gaze_point.color = { 0, 220, 220 };
+            }
+            else {
+                gaze_point.color = { 0, 0, 220 };
+            }
+            gaze_point.visible = true;
+        }
+
+        auto& heatmap = scene_[heatmap_];
+        HeatSample sample;
+        while (heat_samples_.try_pop(sample))
+            heatmap.add(sample.point, sample.timestamp_us);
+        heatmap.update(steadyMicros());
+
+        CalibrationEvent event;
+        while (calibration_events_.try_pop(event)) {
+            auto& calibration_point = scene_[calibration_point_];
+            auto& calibration_desc = scene_[calibration_desc_];
+            switch (event.type) {
+            case CalibrationEvent::kStart:
+                calibration_desc.visible = true;
+                for (const auto& desc : desc_)
+                    scene_[desc].visible = false;
+                scene_[frame_].visible = false;
+                break;
+            case CalibrationEvent::kPoint:
+                calibration_point.center = event.point;
+                calibration_point.visible = true;
+                calibration_desc.visible = false;
+                break;
+            case CalibrationEvent::kFinish:
+                calibration_desc.visible = false;
+                calibration_point.visible = false;
+                for (const auto& desc : desc_)
+                    scene_[desc].visible = true;
+                scene_[frame_].visible = true;
+                break;
+            }
+        }
+    }
+
+    cv::Point View::toRender(int x, int y) const {
+        return {
+            static_cast<int>(std::lround(x * render_scale_)),
+            static_cast<int>(std::lround(y * render_scale_)) };
     }
 
-    void View::setFrame(const cv::Mat& frame) {
-        frame_.buffer = frame;
+    int View::toRender(int length) const {
+        return std::max(1, static_cast<int>(std::lround(length * render_scale_)));
+    }
+
+    cv::Point View::toRenderSubpixel(int x, int y) const {
+        const auto scale = render_scale_ * (1 << kSubpixelShift);
+        return {
+            static_cast<int>(std::lround(x * scale)),
+            static_cast<int>(std::lround(y * scale)) };
+    }
+
+    int View::toRenderSubpixel(int length) const {
+        const auto one = 1 << kSubpixelShift;
+        return std::max(one, static_cast<int>(std::lround(length * render_scale_ * one)));
     }
 
     int View::draw(int wait_ms) {
-        clearBackground();
-        drawElements();
-        return drawWindow(wait_ms);
+        const auto start_us = steadyMicros();
+        ++draws_;
+        if (drawElements()) {
+            if (recorder_)
+                recorder_->write(background_, start_us);
+
+            if (headless_) {
+                // Nothing to present
+            }
+            else if (background_.size() == window_size_) {
+                cv::imshow(window_name_, background_);
+            }
+            else {
+                cv::resize(background_, present_, window_size_, 0, 0, cv::INTER_LINEAR);
+                cv::imshow(window_name_, present_);
+            }
+            ++updates_;
+        }
+        render_us_ += steadyMicros() - start_us;
+
+        int key = -1;
+        // HighGUI shows the image while waitKey() pumps the window events
+        if (!headless_)
+            key = cv::waitKey(wait_ms);
+        if (drawn_gaze_us_ != 0) {
+            gaze_latency_.add(steadyMicros() - drawn_gaze_us_);
+            drawn_gaze_us_ = 0;
+        }
+        return key;
+    }
+
+    int View::update() {
+        scheduler_.wait();
+        // waitKey() also pumps the window events, so keep its wait minimal
+        return draw(1);
     }
 
     void View::closeWindow() {
-        cv::destroyWindow(window_name_);
+        if (!headless_)
+            cv::destroyWindow(window_name_);
+    }
+
+    void View::invalidate() {
+        redraw_all_.store(true, std::memory_order_relaxed);
+        scheduler_.notify();
+    }
+
+    View::Stats View::stats() const {
+        Stats stats;
+        stats.draws = draws_;
+        stats.updates = updates_;
+        if (draws_ > 0)
+            stats.mean_render_us = static_cast<double>(render_us_) / static_cast<double>(draws_);
+        if (updates_ > 0)
+            stats.mean_dirty_fraction = dirty_fraction_ / static_cast<double>(updates_);
+        return stats;
     }
 
     const std::string& View::getWindowName() const {
@@ -36,49 +205,98 @@ namespace sample {
     }
 
     void View::initElements() {
-        gaze_point_.color = { 0, 220, 220 };
+        // Sizes are given in window pixels and scaled to the back buffer.
+        // Elements are stacked in the order they are added.
+        drawables::Image frame;
+        frame.size = { toRender(1280), toRender(720) };
+        preview_size_ = frame.size;
+        frame.buffer = cv::Mat(1080, 1920, CV_8UC3, cv::Scalar(0, 0, 0));
+        frame_ = scene_.add(frame);
 
-        calibration_point_.visible = false;
-        calibration_point_.color = { 0, 0, 255 };
-        calibration_point_.radius = 50;
+        drawables::Heatmap heatmap;
+        heatmap.reset({ 0, 0, background_.cols, background_.rows }, toRender(40));
+        heatmap.visible = false;
+        heatmap_ = scene_.add(std::move(heatmap));
 
-        calibration_desc_.text = "Stare at the red circle until it disappears or moves to other place.";
-        calibration_desc_.org = { background_.cols / 2, background_.rows / 2 };
-        calibration_desc_.visible = false;
+        drawables::Circle gaze_point;
+        gaze_point.color = { 0, 220, 220 };
+        gaze_point.radius = toRenderSubpixel(gaze_point.radius);
+        gaze_point.shift = kSubpixelShift;
+        gaze_point_ = scene_.add(gaze_point);
 
-        frame_.size = { 1280, 720 };
-        frame_.buffer = cv::Mat(1080, 1920, CV_8UC3, cv::Scalar(0, 0, 0));
+        drawables::Circle calibration_point;
+        calibration_point.visible = false;
+        calibration_point.color = { 0, 0, 255 };
+        calibration_point.radius = toRenderSubpixel(50);
+        calibration_point.shift = kSubpixelShift;
+        calibration_point_ = scene_.add(calibration_point);
 
-        desc_.resize(2);
-        desc_[0].text = "Press ESC to exit program, Press 'C' to start calibration";
-        desc_[1].text = "Do not resize the window manually after created";
-        desc_[1].color = { 0, 0, 220 };
+        drawables::Text calibration_desc;
+        calibration_desc.text = "Stare at the red circle until it disappears or moves to other place.";
+        calibration_desc.org = { background_.cols / 2, background_.rows / 2 };
+        calibration_desc.fontScale = render_scale_;
+        calibration_desc.visible = false;
+        calibration_desc_ = scene_.add(calibration_desc);
 
-        for (int i = 0; i < desc_.size(); ++i) {
-            desc_[desc_.size() - 1 - i].fontScale = 1.5;
-            desc_[desc_.size() - 1 - i].org = { 50, background_.rows - 50 * (i + 1) };
+        const char* const texts[] = {
+            "Press ESC to exit program, Press 'C' to start calibration, Press 'H' to toggle the heatmap",
+            "Do not resize the window manually after created",
+        };
+        const int count = static_cast<int>(sizeof(texts) / sizeof(texts[0]));
+        for (int i = 0; i < count; ++i) {
+            drawables::Text desc;
+            desc.text = texts[i];
+            if (i == 1)
+                desc.color = { 0, 0, 220 };
+            desc.fontScale = 1.5 * render_scale_;
+            desc.org = { toRender(50), background_.rows - toRender(50) * (count - i) };
+            desc_.push_back(scene_.add(desc));
         }
     }
 
-    void View::clearBackground() {
-        std::memset(background_.data, 0, background_.rows * background_.cols * background_.channels());
+    bool View::drawElements() {
+        applyUpdates();
+
+        dirty_.clear();
+        if (redraw_all_.exchange(false, std::memory_order_relaxed))
+            addDirty({ 0, 0, background_.cols, background_.rows });
+        scene_.collectDirty([this](const cv::Rect& rect) { addDirty(rect); });
+        if (dirty_.empty())
+            return false;
+
+        int area = 0;
+        for (const auto& region : dirty_) {
+            drawRegion(region);
+            area += region.area();
+        }
+        dirty_fraction_ += static_cast<double>(area) / static_cast<double>(background_.rows * background_.cols);
+        return true;
     }
 
-    void View::drawElements() {
-        read_lock_guard lock(read_mutex());
+    void View::addDirty(const cv::Rect& rect) {
+        auto region = rect & cv::Rect(0, 0, background_.cols, background_.rows);
+        if (region.empty())
+            return;
 
-        drawables::draw_if(frame_, &background_);
-        drawables::draw_if(gaze_point_, &background_);
-        drawables::draw_if(calibration_point_, &background_);
-        drawables::draw_if(calibration_desc_, &background_);
-        for (const auto& desc : desc_)
-            drawables::draw_if(desc, &background_);
+        // Merge overlapping regions so that no pixel is drawn twice
+        for (auto it = dirty_.begin(); it != dirty_.end();) {
+            if ((*it & region).empty()) {
+                ++it;
+                continue;
+            }
+            region |= *it;
+            dirty_.erase(it);
+            it = dirty_.begin();
+        }
+        dirty_.push_back(region);
     }
 
-    int View::drawWindow(int wait_ms) {
-        cv::imshow(window_name_, background_);
-        int key = cv::waitKey(wait_ms);
-        return key;
+    void View::drawRegion(const cv::Rect& region) {
+        // Elements are drawn into the region only, in the same order as a full redraw
+        auto roi = background_(region);
+        roi.setTo(cv::Scalar(0, 0, 0));
+
+        scene_.draw(&roi, region);
     }
 
 } // namespace sample
@@ -7,55 +7,219 @@
 #ifndef EYEDID_CPP_SAMPLE_VIEW_H_
 #define EYEDID_CPP_SAMPLE_VIEW_H_
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 #include "opencv2/opencv.hpp"
 
+#include "bounded_queue.h"
 #include "drawables.h"
-#include "priority_mutex.h"
+#include "latency_stats.h"
+#include "render_scheduler.h"
+#include "scene.h"
+#include "triple_buffer.h"
+#include "video_recorder.h"
 
 namespace sample {
 
-using read_lock_guard = std::lock_guard<typename PriorityMutex::high_mutex_type>;
-using read_unique_lock = std::unique_lock<typename PriorityMutex::high_mutex_type>;
-
-using write_lock_guard = std::lock_guard<typename PriorityMutex::low_mutex_type>;
-using write_unique_lock = std::unique_lock<typename PriorityMutex::low_mutex_type>;
-
+/**
+ * Only regions whose elements changed since the last draw are cleared and redrawn,
+ * and the window is not updated at all when nothing changed.
+ *
+ * Elements are composed in a back buffer of `render_scale` times the window size,
+ * which is upscaled once when presented. Element coordinates are in back buffer pixels;
+ * map window coordinates, e.g. gaze points, with toRender().
+ *
+ * Elements belong to the thread that calls draw(). Other threads publish gaze points,
+ * preview frames and calibration state with the methods below, which never block;
+ * draw() picks up the newest state without taking a lock.
+ *
+ * Each of those methods also wakes the render loop through scheduler(), so update()
+ * only redraws when something changed.
+ *
+ * A headless view composes into memory only: it creates no window, never calls into
+ * HighGUI and draw() does not wait for keys. Attach a VideoRecorder to keep the output.
+ */
 class View {
  public:
-  View(int width, int height, std::string windowName);
-
-  void setPoint(int x, int y);
-  void setFrame(const cv::Mat& frame);
+  struct Stats {
+    /** draw() calls */
+    std::uint64_t draws = 0;
+    /** draw() calls that updated the window */
+    std::uint64_t updates = 0;
+    /** Mean time spent rendering and updating the window per draw() call, excluding waitKey */
+    double mean_render_us = 0;
+    /** Mean fraction of the view redrawn per update */
+    double mean_dirty_fraction = 0;
+  };
+
+  /**
+   * @param width, height  window size in pixels
+   * @param render_scale   back buffer size relative to the window, in (0, 1]
+   * @param headless       compose offscreen instead of showing a window
+   */
+  View(int width, int height, std::string windowName, double render_scale = 1.0, bool headless = false);
+
+  /**
+   * Move the gaze point, or mark it red if the gaze could not be estimated.
+   * Valid points also heat up heatmap_.
+   * @param x, y  window coordinates
+   * Call from one thread only, e.g. the SDK callback thread.
+   */
+  void setGaze(int x, int y, bool valid);
+
+  /**
+   * Buffer to write the next preview frame into, scaled to previewSize().
+   * It holds an older frame. Call publishPreview() when done. Use from one thread only.
+   */
+  cv::Mat& previewBuffer() { return preview_.back(); }
+  void publishPreview() {
+    preview_.publish();
+    scheduler_.notify();
+  }
+  cv::Size previewSize() const { return preview_size_; }
+
+  /** Calibration UI. May be called from any thread */
+  void startCalibration();
+  /** @param x, y  window coordinates */
+  void showCalibrationPoint(int x, int y);
+  void finishCalibration();
 
   int draw(int wait_ms = 10);
 
+  /**
+   * Wait for a change or the idle tick of scheduler(), then draw.
+   * @return the key pressed, or -1
+   */
+  int update();
+
+  RenderScheduler& scheduler() { return scheduler_; }
+
+  /**
+   * Pass every window update, at back buffer size, to `recorder`. nullptr stops recording.
+   * The recorder must stay alive while attached. Call from the thread that calls draw().
+   */
+  void setRecorder(VideoRecorder* recorder) { recorder_ = recorder; }
+
+  /** Back buffer size, the size of recorded images */
+  cv::Size renderSize() const { return background_.size(); }
+
+  bool headless() const { return headless_; }
+
   void closeWindow();
 
+  /** Redraw the whole view on the next draw(), e.g. after the window was recreated */
+  void invalidate();
+
+  /** Call from the thread that calls draw() */
+  Stats stats() const;
+
+  /**
+   * Time from setGaze() until the point was shown, i.e. until the window update that
+   * drew it returned from waitKey(). May be called from any thread.
+   */
+  LatencyStats::Snapshot gazeLatency() const { return gaze_latency_.snapshot(); }
+
   const std::string& getWindowName() const;
 
-  drawables::Circle gaze_point_;
-  drawables::Circle calibration_point_;
-  drawables::Text calibration_desc_;
-  drawables::Image frame_;
-  std::vector<drawables::Text> desc_;
+  double renderScale() const { return render_scale_; }
+
+  /** Map window coordinates to back buffer coordinates */
+  cv::Point toRender(int x, int y) const;
+
+  /** Scale a length in window pixels, e.g. a radius, to the back buffer. At least 1 */
+  int toRender(int length) const;
 
-  PriorityMutex::low_mutex_type& write_mutex() { return mutex_.low(); }
+  /** Fractional bits of the toRenderSubpixel() results */
+  static constexpr int kSubpixelShift = 4;
+
+  /**
+   * toRender() in fixed point with kSubpixelShift fractional bits, for elements drawn with
+   * that shift (e.g. drawables::Circle::shift), so that a render scale below 1 keeps the
+   * precision of window coordinates until OpenCV rasterizes them
+   */
+  cv::Point toRenderSubpixel(int x, int y) const;
+  int toRenderSubpixel(int length) const;
+
+  using ViewScene = Scene<drawables::Image, drawables::Heatmap, drawables::Circle, drawables::Text>;
+
+  /**
+   * Every element of the view. Add overlays here; they are redrawn when they change.
+   * Only touch the scene from the thread that calls draw().
+   */
+  ViewScene& scene() { return scene_; }
+
+  drawables::Heatmap& heatmap() { return scene_[heatmap_]; }
 
  private:
+  struct Gaze {
+    /** Back buffer pixels, for the heatmap */
+    cv::Point point;
+    /** toRenderSubpixel(), for the gaze point */
+    cv::Point subpixel;
+    bool valid = false;
+    std::int64_t published_us = 0;
+  };
+
+  struct HeatSample {
+    cv::Point point;
+    std::int64_t timestamp_us = 0;
+  };
+
+  struct CalibrationEvent {
+    enum Type { kStart, kPoint, kFinish };
+    Type type = kStart;
+    /** toRenderSubpixel() */
+    cv::Point point;
+  };
+
   void initElements();
 
-  void clearBackground();
-  void drawElements();
-  int drawWindow(int wait_ms);
+  /** Apply state published by other threads to the elements */
+  void applyUpdates();
+  void postCalibrationEvent(const CalibrationEvent& event);
 
-  PriorityMutex::high_mutex_type& read_mutex() { return mutex_.high(); }
+  /** @return false if nothing changed since the last draw */
+  bool drawElements();
+  void addDirty(const cv::Rect& rect);
+  void drawRegion(const cv::Rect& region);
 
   std::string window_name_;
+  double render_scale_;
+  bool headless_;
+  cv::Size window_size_;
   cv::Mat background_;
-  mutable PriorityMutex mutex_;
+  cv::Mat present_;
+  cv::Size preview_size_;
+
+  triple_buffer<Gaze> gaze_;
+  triple_buffer<cv::Mat> preview_;
+  bounded_queue<CalibrationEvent> calibration_events_{16};
+  // Every sample counts for the heatmap, so they are queued rather than handed over as the latest value
+  bounded_queue<HeatSample> heat_samples_{256};
+  std::atomic_bool redraw_all_{true};
+  RenderScheduler scheduler_;
+  VideoRecorder* recorder_ = nullptr;
+
+  ViewScene scene_;
+  ViewScene::Id<drawables::Image> frame_;
+  ViewScene::Id<drawables::Heatmap> heatmap_;
+  ViewScene::Id<drawables::Circle> gaze_point_;
+  ViewScene::Id<drawables::Circle> calibration_point_;
+  ViewScene::Id<drawables::Text> calibration_desc_;
+  std::vector<ViewScene::Id<drawables::Text>> desc_;
+  std::vector<cv::Rect> dirty_;
+
+  // published_us of the gaze point drawn by the current draw(), 0 if it did not move
+  std::int64_t drawn_gaze_us_ = 0;
+  LatencyStats gaze_latency_;
+
+  std::uint64_t draws_ = 0;
+  std::uint64_t updates_ = 0;
+  std::int64_t render_us_ = 0;
+  double dirty_fraction_ = 0;
 };
 
 } // namespace sample
@@ -0,0 +1,75 @@
+#include "window_geometry.h"
+
+#include <utility>
+
+namespace sample {
+
+WindowGeometry::WindowGeometry(std::string window_name, int poll_interval_ms)
+  : window_name_(std::move(window_name)),
+    poll_interval_us_(static_cast<std::int64_t>(poll_interval_ms) * 1000) {}
+
+void WindowGeometry::refresh() {
+  if (fixed_)
+    return;
+  queries_.fetch_add(1, std::memory_order_relaxed);
+  const auto current = eyedid::getWindowRect(window_name_);
+  const auto cached = rect();
+  if (current.x != cached.x || current.y != cached.y ||
+      current.width != cached.width || current.height != cached.height) {
+    changes_.fetch_add(1, std::memory_order_relaxed);
+    store(current);
+  }
+}
+
+bool WindowGeometry::poll(std::int64_t now_us) {
+  if (fixed_ || now_us - last_poll_us_ < poll_interval_us_)
+    return false;
+  last_poll_us_ = now_us;
+  refresh();
+  return true;
+}
+
+void WindowGeometry::setFixed(const eyedid::Rect& rect) {
+  fixed_ = true;
+  store(rect);
+}
+
+void WindowGeometry::store(const eyedid::Rect& rect) {
+  const auto sequence = sequence_.load(std::memory_order_relaxed);
+  sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  x_.store(rect.x, std::memory_order_relaxed);
+  y_.store(rect.y, std::memory_order_relaxed);
+  width_.store(rect.width, std::memory_order_relaxed);
+  height_.store(rect.height, std::memory_order_relaxed);
+  sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+eyedid::Rect WindowGeometry::rect() const {
+  eyedid::Rect rect;
+  std::uint32_t before, after;
+  do {
+    before = sequence_.load(std::memory_order_acquire);
+    rect.x = x_.load(std::memory_order_relaxed);
+    rect.y = y_.load(std::memory_order_relaxed);
+    rect.width = width_.load(std::memory_order_relaxed);
+    rect.height = height_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = sequence_.load(std::memory_order_relaxed);
+  } while (before != after || (before & 1));
+  return rect;
+}
+
+eyedid::Point<long> WindowGeometry::position() const {
+  const auto window = rect();
+  return { static_cast<long>(window.x), static_cast<long>(window.y) };
+}
+
+WindowGeometry::Stats WindowGeometry::stats() const {
+  Stats stats;
+  stats.queries = queries_.load(std::memory_order_relaxed);
+  stats.changes = changes_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+} // namespace sample
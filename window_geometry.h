@@ -0,0 +1,77 @@
+/**
+ * Cached position and size of a window.
+ *
+ * Asking the window manager is a system call, too slow to repeat for every gaze sample
+ * on the SDK's callback thread. The thread that owns the window refreshes the cache
+ * instead, when told the window changed or at a low rate with poll(). Any thread
+ * reads the cached rectangle without locking.
+ */
+
+#ifndef EYEDID_CPP_SAMPLE_WINDOW_GEOMETRY_H_
+#define EYEDID_CPP_SAMPLE_WINDOW_GEOMETRY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "eyedid/util/display.h"
+
+namespace sample {
+
+class WindowGeometry {
+ public:
+  struct Stats {
+    /** Window manager queries */
+    std::uint64_t queries = 0;
+    /** Queries that found the window moved or resized */
+    std::uint64_t changes = 0;
+  };
+
+  /**
+   * @param window_name       the window to query
+   * @param poll_interval_ms  how often poll() queries the window
+   */
+  explicit WindowGeometry(std::string window_name, int poll_interval_ms = 250);
+
+  WindowGeometry(const WindowGeometry&) = delete;
+  WindowGeometry& operator=(const WindowGeometry&) = delete;
+
+  /** Query the window now, e.g. after it was moved or recreated. Call from the window's thread */
+  void refresh();
+
+  /**
+   * refresh() if the poll interval passed since the last query. Call from the window's loop.
+   * @return true if the window was queried
+   */
+  bool poll(std::int64_t now_us);
+
+  /** Use this rectangle and stop querying, e.g. for a headless view that has no window */
+  void setFixed(const eyedid::Rect& rect);
+
+  /** May be called from any thread */
+  eyedid::Rect rect() const;
+
+  /** May be called from any thread */
+  eyedid::Point<long> position() const;
+
+  Stats stats() const;
+
+ private:
+  void store(const eyedid::Rect& rect);
+
+  std::string window_name_;
+  std::int64_t poll_interval_us_;
+  std::int64_t last_poll_us_ = 0;
+  bool fixed_ = false;
+
+  // Seqlock: odd while store() runs. There is one writer; readers retry on a change
+  std::atomic<std::uint32_t> sequence_{0};
+  std::atomic<double> x_{0}, y_{0}, width_{0}, height_{0};
+
+  std::atomic<std::uint64_t> queries_{0};
+  std::atomic<std::uint64_t> changes_{0};
+};
+
+} // namespace sample
+
+#endif // EYEDID_CPP_SAMPLE_WINDOW_GEOMETRY_H_